@@ -1,5 +1,10 @@
 #include "MemoryLeakDetector.h"
 
+#include <mutex>
+
+// guards the map, since operator new can be called from several threads at once
+static std::mutex track_mutex;
+
 track_type* get_map() {
   // don't use normal new to avoid infinite recursion.
   static track_type* track = new (std::malloc(sizeof *track)) track_type;
@@ -13,14 +18,18 @@ void* operator new(std::size_t size) noexcept(false) {
   if (mem == 0) {
     throw std::bad_alloc();
   }
+  std::lock_guard<std::mutex> lock(track_mutex);
   (*get_map())[mem] = size;
   return mem;
 }
 
 void operator delete(void* mem) noexcept {
+  if (mem == nullptr) return;
+  std::unique_lock<std::mutex> lock(track_mutex);
   if (get_map()->erase(mem) == 0) {
     // this indicates a serious bug
     std::cerr << "bug: memory at " << mem << " wasn't allocated by us\n";
   }
+  lock.unlock();
   std::free(mem);
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+//
+//  ingest_bench.cpp
+//
+//  Rows/s, MB/s and peak memory of the CSV ingestion paths on synthetic
+//  files of several sizes, written to ingest_results.csv.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include <chrono>
+#include <cstdio>  // for remove()
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#  define NOMINMAX
+#  include <windows.h>
+#  include <psapi.h>
+#elif defined(__linux__)
+#  include <malloc.h>  // for malloc_trim()
+#else
+#  include <sys/resource.h>
+#endif
+
+#include "SyntheticData.h"
+#include "csv.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace csi281;
+
+static const int YEARS_PER_STATION = 60;
+
+// Highest resident memory of the process since the last resetPeakMemory()
+// on Linux, and since it started elsewhere, in bytes
+static double peakMemoryBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+  return static_cast<double>(counters.PeakWorkingSetSize);
+#elif defined(__linux__)
+  // ru_maxrss is never reset, but VmHWM follows clear_refs
+  ifstream status("/proc/self/status");
+  string line;
+  while (getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) return atof(line.c_str() + 6) * 1024.0;  // kB
+  }
+  return 0;
+#else
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#  ifdef __APPLE__
+  return static_cast<double>(usage.ru_maxrss);  // already bytes
+#  else
+  return usage.ru_maxrss * 1024.0;  // kilobytes
+#  endif
+#endif
+}
+
+// Start the peak over from what is resident now, where the OS allows it
+// (Linux only); elsewhere peaks only ever grow, so run the sizes smallest first.
+// The heap an earlier run freed is handed back first, or it would still be
+// resident and count towards the new peak.
+static void resetPeakMemory() {
+#ifdef __linux__
+#  ifdef __GLIBC__
+  malloc_trim(0);
+#  endif
+  ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+#endif
+}
+
+struct IngestPath {
+  string name;
+  function<CityMap(const string &)> read;
+};
+
+int main(int argc, char *argv[]) {
+  vector<long long> sizes;  // rows per file
+  for (int i = 1; i < argc; i++) sizes.push_back(atoll(argv[i]));
+  if (sizes.empty()) sizes = {120000, 1200000, 6000000};
+
+  vector<IngestPath> paths = {
+      {"readAllCities", [](const string &fileName) { return readAllCities(fileName); }},
+      {"readAllCitiesParallel",
+       [](const string &fileName) { return readAllCitiesParallel(fileName); }},
+  };
+
+  ofstream results("ingest_results.csv");
+  results << "path,rows,bytes,seconds,rows_per_s,mb_per_s,peak_mb" << endl;
+  for (long long rows : sizes) {
+    const string fileName = "ingest_bench_" + to_string(rows) + ".csv";
+    SyntheticOptions options;
+    options.stations = (rows + YEARS_PER_STATION - 1) / YEARS_PER_STATION;
+    options.yearsPerStation = YEARS_PER_STATION;
+    rows = options.stations * YEARS_PER_STATION;
+    double bytes = static_cast<double>(writeSyntheticData(fileName, options));
+    cout << rows << " rows, " << bytes / 1e6 << " MB" << endl;
+
+    for (const IngestPath &path : paths) {
+      resetPeakMemory();
+      auto start = steady_clock::now();
+      size_t stations = path.read(fileName).size();
+      double seconds = duration<double>(steady_clock::now() - start).count();
+      double peakMB = peakMemoryBytes() / 1e6;
+      if (stations != static_cast<size_t>(options.stations)) {
+        cout << path.name << " found " << stations << " of " << options.stations << " stations!"
+             << endl;
+        return 1;
+      }
+
+      cout << "  " << path.name << ": " << seconds * 1000 << " ms, "
+           << static_cast<long long>(rows / seconds) << " rows/s, " << bytes / 1e6 / seconds
+           << " MB/s, peak " << peakMB << " MB" << endl;
+      results << path.name << "," << rows << "," << static_cast<long long>(bytes) << ","
+              << seconds << "," << rows / seconds << "," << bytes / 1e6 / seconds << "," << peakMB
+              << endl;
+    }
+    remove(fileName.c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+//
+//  parse_bench.cpp
+//
+//  Microbenchmark of the stream based cell readers (readLine() on top of
+//  readIntCell() and readFloatCell()) against the allocation-free
+//  parseIntCell() and parseFloatCell() over a synthetic file.
+//
+//  Usage: assignment01_parse_bench [rows]
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>  // for min()
+#include <chrono>
+#include <cstdio>  // for remove()
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "CsvSchema.h"
+#include "MappedFile.h"
+#include "SyntheticData.h"
+#include "csv.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace csi281;
+
+static void report(const string &name, const int rows, nanoseconds time) {
+  double seconds = duration<double>(time).count();
+  cout << name << ": " << duration_cast<milliseconds>(time).count() << " ms, "
+       << time.count() / rows << " ns/row, " << static_cast<long long>(rows / seconds)
+       << " rows/s" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  // plain names, so readLine() (which splits on every comma) can keep up
+  SyntheticOptions options;
+  options.stations = ((argc > 1 ? atoi(argv[1]) : 2000000) + 59) / 60;
+  options.punctuatedNames = false;
+  const int rows = static_cast<int>(options.stations * options.yearsPerStation);
+  const string fileName = "parse_bench.csv";
+  cout << "Writing " << rows << " synthetic rows..." << endl;
+  writeSyntheticData(fileName, options);
+
+  // getline() and an istringstream per line, a string, clean() and stoi()/stof() per cell
+  double streamChecksum = 0;
+  auto start = steady_clock::now();
+  {
+    ifstream file(fileName);
+    string header;
+    getline(file, header);
+    for (int i = 0; i < rows; i++) {
+      CityYear year = readLine(file);
+      streamChecksum += year.year + year.numDaysBelow32 + year.numDaysAbove90
+                        + year.averageTemperature + year.averageMax + year.averageMin;
+    }
+  }
+  nanoseconds streamTime = steady_clock::now() - start;
+
+  // views into the mapped file and from_chars() per cell
+  double viewChecksum = 0;
+  int errors = 0;
+  start = steady_clock::now();
+  {
+    MappedFile file(fileName);
+    string_view rest = file.view();
+    rest.remove_prefix(min(rest.find('\n') + 1, rest.size()));  // header
+    while (!rest.empty()) {
+      size_t newline = rest.find('\n');
+      string_view line = rest.substr(0, newline);
+      rest.remove_prefix(newline == string_view::npos ? rest.size() : newline + 1);
+      CityYear year;
+      nextCell(line);  // STATION
+      nextCell(line);  // NAME
+      errors += parseIntCell(nextCell(line), year.year) != CellError::None;
+      errors += parseIntCell(nextCell(line), year.numDaysBelow32) != CellError::None;
+      errors += parseIntCell(nextCell(line), year.numDaysAbove90) != CellError::None;
+      errors += parseFloatCell(nextCell(line), year.averageTemperature) != CellError::None;
+      errors += parseFloatCell(nextCell(line), year.averageMax) != CellError::None;
+      errors += parseFloatCell(nextCell(line), year.averageMin) != CellError::None;
+      viewChecksum += year.year + year.numDaysBelow32 + year.numDaysAbove90
+                      + year.averageTemperature + year.averageMax + year.averageMin;
+    }
+  }
+  nanoseconds viewTime = steady_clock::now() - start;
+
+  // the same cells, with the column order looked up from the header
+  double schemaChecksum = 0;
+  start = steady_clock::now();
+  {
+    MappedFile file(fileName);
+    string_view rest = file.view();
+    auto schema = cityYearSchema();
+    size_t newline = rest.find('\n');
+    schema.resolve(rest.substr(0, newline));
+    rest.remove_prefix(min(newline + 1, rest.size()));
+    while (!rest.empty()) {
+      newline = rest.find('\n');
+      string_view line = rest.substr(0, newline);
+      rest.remove_prefix(newline == string_view::npos ? rest.size() : newline + 1);
+      CityYear year;
+      errors += schema.parse(line, year) != CellError::None;
+      schemaChecksum += year.year + year.numDaysBelow32 + year.numDaysAbove90
+                        + year.averageTemperature + year.averageMax + year.averageMin;
+    }
+  }
+  nanoseconds schemaTime = steady_clock::now() - start;
+
+  report("stream cells (readLine)      ", rows, streamTime);
+  report("from_chars cells (parse*Cell)", rows, viewTime);
+  report("schema mapped (CsvSchema)    ", rows, schemaTime);
+  cout << "speedup: " << static_cast<double>(streamTime.count()) / viewTime.count() << "x" << endl;
+  bool differ = streamChecksum != viewChecksum || viewChecksum != schemaChecksum;
+  if (errors != 0 || differ) cout << "results differ! (" << errors << " malformed cells)" << endl;
+  remove(fileName.c_str());
+  return errors != 0 || differ;
+}
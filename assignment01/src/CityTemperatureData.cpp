@@ -27,52 +27,254 @@
 
 #include "CityTemperatureData.h"
 
+#include <algorithm>  // for max()
+#include <cstring>    // for memcpy()
+#include <limits>
+#include <new>  // for align_val_t
+#include <stdexcept>
+
+#include "kernels.h"
+
 using namespace std;
 
 namespace csi281 {
+  // Columns start on their own cache line and are padded to whole lines,
+  // so the vector kernels never straddle two columns
+  static const size_t COLUMN_ALIGNMENT = 64;
+
+  static size_t columnBytes(int numYears) {
+    size_t bytes = static_cast<size_t>(numYears) * sizeof(int);
+    return (bytes + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+  }
+
   // Fill in all instance variables for CityTemperatureData.
-  // Data will be stored in an array of CityYear instances.
+  // The CityYear array is split into columns and then released, since the
+  // class takes ownership of it.
   CityTemperatureData::CityTemperatureData(const string name, CityYear data[], int numYears)
-      : _name(name), _data(data), _count(numYears) {}
+      : _name(name),
+        _count(0),
+        _capacity(0),
+        _storage(nullptr),
+        _years(nullptr),
+        _daysBelow32(nullptr),
+        _daysAbove90(nullptr),
+        _averageTemperatures(nullptr),
+        _averageMaxes(nullptr),
+        _averageMins(nullptr) {
+    reserve(numYears);
+    int* years = ownedColumn<int>(0);
+    int* daysBelow32 = ownedColumn<int>(1);
+    int* daysAbove90 = ownedColumn<int>(2);
+    float* averageTemperatures = ownedColumn<float>(3);
+    float* averageMaxes = ownedColumn<float>(4);
+    float* averageMins = ownedColumn<float>(5);
+    for (int i = 0; i < numYears; i++) {
+      years[i] = data[i].year;
+      daysBelow32[i] = data[i].numDaysBelow32;
+      daysAbove90[i] = data[i].numDaysAbove90;
+      averageTemperatures[i] = data[i].averageTemperature;
+      averageMaxes[i] = data[i].averageMax;
+      averageMins[i] = data[i].averageMin;
+    }
+    delete[] data;
+    _count = numYears;
+    computeAggregates();
+  }
+
+  // A city without any years yet, to append() to.
+  CityTemperatureData::CityTemperatureData(const string name)
+      : CityTemperatureData(name, new CityYear[0], 0) {}
+
+  // Borrow columns that live in someone else's memory.
+  CityTemperatureData::CityTemperatureData(const string name, CityColumns columns, int numYears,
+                                           shared_ptr<const void> backing)
+      : _name(name),
+        _count(numYears),
+        _capacity(0),
+        _storage(nullptr),
+        _backing(std::move(backing)),
+        _years(columns.years),
+        _daysBelow32(columns.daysBelow32),
+        _daysAbove90(columns.daysAbove90),
+        _averageTemperatures(columns.averageTemperatures),
+        _averageMaxes(columns.averageMaxes),
+        _averageMins(columns.averageMins) {
+    computeAggregates();
+  }
 
   // Release any memory connected to CityTemperatureData.
   CityTemperatureData::~CityTemperatureData() {
-    delete _data;
+    if (_storage != nullptr) ::operator delete(_storage, align_val_t(COLUMN_ALIGNMENT));
+  }
+
+  // Start of one of the six columns in the owned block
+  template <typename T> T* CityTemperatureData::ownedColumn(const int column) {
+    return reinterpret_cast<T*>(_storage + column * columnBytes(_capacity));
+  }
+
+  // Make sure there is owned room for capacity years, copying the columns
+  // over into a new block if there isn't (or if they are borrowed)
+  void CityTemperatureData::reserve(const int capacity) {
+    if (_storage != nullptr && capacity <= _capacity) return;
+    int newCapacity = max(capacity, _count);
+    size_t stride = columnBytes(newCapacity);
+    char* storage = static_cast<char*>(
+        ::operator new(max(stride * 6, COLUMN_ALIGNMENT), align_val_t(COLUMN_ALIGNMENT)));
+    const void* columns[6] = {_years, _daysBelow32, _daysAbove90,
+                              _averageTemperatures, _averageMaxes, _averageMins};
+    for (int column = 0; column < 6 && _count > 0; column++) {
+      memcpy(storage + column * stride, columns[column], _count * sizeof(int));
+    }
+    if (_storage != nullptr) ::operator delete(_storage, align_val_t(COLUMN_ALIGNMENT));
+    _backing.reset();
+    _storage = storage;
+    _capacity = newCapacity;
+    _years = ownedColumn<int>(0);
+    _daysBelow32 = ownedColumn<int>(1);
+    _daysAbove90 = ownedColumn<int>(2);
+    _averageTemperatures = ownedColumn<float>(3);
+    _averageMaxes = ownedColumn<float>(4);
+    _averageMins = ownedColumn<float>(5);
+  }
+
+  // Add the year after the last one. The columns grow by doubling (from the
+  // count for borrowed columns, which have no capacity), and the running
+  // aggregates (and the range index, if there is one) are updated in
+  // constant time.
+  void CityTemperatureData::append(const CityYear& year) {
+    if (_count > 0 && year.year != _years[_count - 1] + 1) {
+      throw invalid_argument("years have to be appended in order without gaps");
+    }
+    if (_storage == nullptr || _count == _capacity) reserve(max(2 * max(_capacity, _count), 16));
+    ownedColumn<int>(0)[_count] = year.year;
+    ownedColumn<int>(1)[_count] = year.numDaysBelow32;
+    ownedColumn<int>(2)[_count] = year.numDaysAbove90;
+    ownedColumn<float>(3)[_count] = year.averageTemperature;
+    ownedColumn<float>(4)[_count] = year.averageMax;
+    ownedColumn<float>(5)[_count] = year.averageMin;
+    _count++;
+
+    _sumAverageTemperature += year.averageTemperature;
+    _totalDaysBelow32 += year.numDaysBelow32;
+    _totalDaysAbove90 += year.numDaysAbove90;
+    _allTimeMax = max(_allTimeMax, year.averageMax);
+    _allTimeMin = min(_allTimeMin, year.averageMin);
+    if (_rangeIndex != nullptr) {
+      _rangeIndex->averageTemperatures.push_back(_rangeIndex->averageTemperatures.back()
+                                                 + year.averageTemperature);
+      _rangeIndex->averageMaxes.push_back(_rangeIndex->averageMaxes.back() + year.averageMax);
+      _rangeIndex->averageMins.push_back(_rangeIndex->averageMins.back() + year.averageMin);
+      _rangeIndex->daysBelow32.push_back(_rangeIndex->daysBelow32.back() + year.numDaysBelow32);
+      _rangeIndex->daysAbove90.push_back(_rangeIndex->daysAbove90.back() + year.numDaysAbove90);
+    }
+  }
+
+  // Work out the all time aggregates once, append() keeps them up to date
+  void CityTemperatureData::computeAggregates() {
+    _sumAverageTemperature = sumColumn(_averageTemperatures, _count);
+    _totalDaysBelow32 = sumColumn(_daysBelow32, _count);
+    _totalDaysAbove90 = sumColumn(_daysAbove90, _count);
+    _allTimeMax = maxColumn(_averageMaxes, _count);
+    _allTimeMin = minColumn(_averageMins, _count);
   }
 
   // Look up a CityYear instance held by CityTemperatureData by its year.
-  // Find the right CityYear in the array and return it
+  // Gather the year back together from the columns
   const CityYear CityTemperatureData::operator[](const int year) const {
     int index = year - getFirstYear();
-    return *(_data + index);
+    return {_years[index], _daysBelow32[index], _daysAbove90[index],
+            _averageTemperatures[index], _averageMaxes[index], _averageMins[index]};
   }
 
   // Get the average (mean) temperature of all time for this city
   // by averaging every CityYear.
-  float CityTemperatureData::getAllTimeAverage() const { 
-      float total = 0;
-      for (int i = 0; i < _count; i++) {
-          total += _data[i].averageTemperature;
-      }
-      total /= _count;
-      return total;
+  float CityTemperatureData::getAllTimeAverage() const {
+    return static_cast<float>(_sumAverageTemperature / _count);
   }
 
   // Sum all of the days below 32 for all years.
-  int CityTemperatureData::getTotalDaysBelow32() const {
-    int total = 0;
-    for (int i = 0; i < _count; i++) {
-      total += _data[i].numDaysBelow32;
+  int CityTemperatureData::getTotalDaysBelow32() const { return _totalDaysBelow32; }
+
+  // Sum all of the days above 90 for all years.
+  int CityTemperatureData::getTotalDaysAbove90() const { return _totalDaysAbove90; }
+
+  // Highest average maximum of any year.
+  float CityTemperatureData::getAllTimeMax() const { return _allTimeMax; }
+
+  // Lowest average minimum of any year.
+  float CityTemperatureData::getAllTimeMin() const { return _allTimeMin; }
+
+  // Clip a year range to the data, as [first, last) indices into the columns;
+  // a range before, after or between the years (toYear < fromYear) is empty.
+  // The offsets are worked out in long long so open ranges like
+  // INT_MIN to INT_MAX don't overflow.
+  pair<int, int> CityTemperatureData::yearIndices(const int fromYear, const int toYear) const {
+    if (_count == 0) return {0, 0};
+    long long firstYear = getFirstYear();
+    int first = static_cast<int>(clamp<long long>(fromYear - firstYear, 0, _count));
+    int last = static_cast<int>(clamp<long long>(toYear - firstYear + 1, 0, _count));
+    return {first, max(first, last)};
+  }
+
+  // Mean of a float column over a year range, from the prefix sums if there
+  // are any and by scanning the range otherwise
+  float CityTemperatureData::rangeAverage(const float* column,
+                                          const vector<double> RangeIndex::*prefix,
+                                          const int fromYear, const int toYear) const {
+    auto [first, last] = yearIndices(fromYear, toYear);
+    if (first == last) return numeric_limits<float>::quiet_NaN();
+    double total = _rangeIndex != nullptr
+                       ? ((*_rangeIndex).*prefix)[last] - ((*_rangeIndex).*prefix)[first]
+                       : sumColumn(column + first, last - first);
+    return static_cast<float>(total / (last - first));
+  }
+
+  // Sum of an int column over a year range
+  int CityTemperatureData::rangeTotal(const int* column,
+                                      const vector<long long> RangeIndex::*prefix,
+                                      const int fromYear, const int toYear) const {
+    auto [first, last] = yearIndices(fromYear, toYear);
+    if (_rangeIndex != nullptr) {
+      return static_cast<int>(((*_rangeIndex).*prefix)[last] - ((*_rangeIndex).*prefix)[first]);
     }
-    return total;
+    return sumColumn(column + first, last - first);
   }
 
-  // Sum all of the days above 90 for all years.
-  int CityTemperatureData::getTotalDaysAbove90() const {
-    int total = 0;
+  float CityTemperatureData::getAverage(const int fromYear, const int toYear) const {
+    return rangeAverage(_averageTemperatures, &RangeIndex::averageTemperatures, fromYear, toYear);
+  }
+
+  float CityTemperatureData::getAverageMax(const int fromYear, const int toYear) const {
+    return rangeAverage(_averageMaxes, &RangeIndex::averageMaxes, fromYear, toYear);
+  }
+
+  float CityTemperatureData::getAverageMin(const int fromYear, const int toYear) const {
+    return rangeAverage(_averageMins, &RangeIndex::averageMins, fromYear, toYear);
+  }
+
+  int CityTemperatureData::getTotalDaysBelow32(const int fromYear, const int toYear) const {
+    return rangeTotal(_daysBelow32, &RangeIndex::daysBelow32, fromYear, toYear);
+  }
+
+  int CityTemperatureData::getTotalDaysAbove90(const int fromYear, const int toYear) const {
+    return rangeTotal(_daysAbove90, &RangeIndex::daysAbove90, fromYear, toYear);
+  }
+
+  // Build prefix sums over the numeric columns
+  void CityTemperatureData::buildRangeIndex() {
+    auto index = make_unique<RangeIndex>();
+    index->averageTemperatures.resize(_count + 1);
+    index->averageMaxes.resize(_count + 1);
+    index->averageMins.resize(_count + 1);
+    index->daysBelow32.resize(_count + 1);
+    index->daysAbove90.resize(_count + 1);
     for (int i = 0; i < _count; i++) {
-      total += _data[i].numDaysAbove90;
+      index->averageTemperatures[i + 1] = index->averageTemperatures[i] + _averageTemperatures[i];
+      index->averageMaxes[i + 1] = index->averageMaxes[i] + _averageMaxes[i];
+      index->averageMins[i + 1] = index->averageMins[i] + _averageMins[i];
+      index->daysBelow32[i + 1] = index->daysBelow32[i] + _daysBelow32[i];
+      index->daysAbove90[i + 1] = index->daysAbove90[i] + _daysAbove90[i];
     }
-    return total;
+    _rangeIndex = std::move(index);
   }
 }  // namespace csi281
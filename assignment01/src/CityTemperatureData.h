@@ -28,7 +28,9 @@
 #ifndef CityTemperatureData_hpp
 #define CityTemperatureData_hpp
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "MemoryLeakDetector.h"
 
@@ -46,23 +48,109 @@ namespace csi281 {
     float averageMin;
   };
 
+  // Pointers to the six columns of a city, each as long as its number of years
+  struct CityColumns {
+    const int* years;
+    const int* daysBelow32;
+    const int* daysAbove90;
+    const float* averageTemperatures;
+    const float* averageMaxes;
+    const float* averageMins;
+  };
+
   // Represents all of the data for a city in aggregate
+  // The years are stored as a struct of arrays, one contiguous column per
+  // CityYear field, so each aggregate only streams through the column it uses
   class CityTemperatureData {
   public:
     CityTemperatureData(const string name, CityYear data[], int numYears);
+    // A city without any years yet, to append() to
+    explicit CityTemperatureData(const string name);
+    // Serve columns that live in someone else's memory, such as a mapped
+    // binary cache, without copying them; backing is kept alive meanwhile
+    CityTemperatureData(const string name, CityColumns columns, int numYears,
+                        shared_ptr<const void> backing);
     ~CityTemperatureData();
+    CityTemperatureData(const CityTemperatureData &) = delete;
+    CityTemperatureData &operator=(const CityTemperatureData &) = delete;
     int count() const { return _count; }
     const string& getName() const { return _name; }
-    int getFirstYear() const { return _data[0].year; }
+    int getFirstYear() const { return _years[0]; }
     const CityYear operator[](const int year) const;
     float getAllTimeAverage() const;
     int getTotalDaysBelow32() const;
     int getTotalDaysAbove90() const;
+    float getAllTimeMax() const;  // highest averageMax of any year
+    float getAllTimeMin() const;  // lowest averageMin of any year
+
+    // Add the year after the last one (invalid_argument for anything else);
+    // the all time aggregates above are kept as running values, so they
+    // cost nothing to read and nothing extra to keep up to date
+    void append(const CityYear& year);
+    // Make room for capacity years, so appending up to it won't reallocate
+    void reserve(const int capacity);
+
+    // Aggregates over the years fromYear to toYear (inclusive), clipped to
+    // the years there is data for. Averages of an empty range are NaN.
+    // They scan the range unless buildRangeIndex() was called, in which
+    // case they take constant time.
+    float getAverage(const int fromYear, const int toYear) const;
+    float getAverageMax(const int fromYear, const int toYear) const;
+    float getAverageMin(const int fromYear, const int toYear) const;
+    int getTotalDaysBelow32(const int fromYear, const int toYear) const;
+    int getTotalDaysAbove90(const int fromYear, const int toYear) const;
+
+    // Build prefix sums over the numeric columns; meant to be called once
+    // right after loading, for cities that get many range queries
+    void buildRangeIndex();
+    bool hasRangeIndex() const { return _rangeIndex != nullptr; }
+
+    // The columns, each count() long and ordered by year
+    const int* years() const { return _years; }
+    const int* daysBelow32() const { return _daysBelow32; }
+    const int* daysAbove90() const { return _daysAbove90; }
+    const float* averageTemperatures() const { return _averageTemperatures; }
+    const float* averageMaxes() const { return _averageMaxes; }
+    const float* averageMins() const { return _averageMins; }
 
   private:
-    string _name;     // name of city
-    CityYear* _data;  // array of CityYear
-    int _count;       // number of years covered by the class
+    // Running totals of every numeric column, count() + 1 long, so the sum
+    // of years [i, j) is prefix[j] - prefix[i]
+    struct RangeIndex {
+      vector<double> averageTemperatures;
+      vector<double> averageMaxes;
+      vector<double> averageMins;
+      vector<long long> daysBelow32;
+      vector<long long> daysAbove90;
+    };
+
+    template <typename T> T* ownedColumn(const int column);
+    void computeAggregates();
+
+    // Clip a year range to the data, as [first, last) indices into the columns
+    pair<int, int> yearIndices(const int fromYear, const int toYear) const;
+    float rangeAverage(const float* column, const vector<double> RangeIndex::*prefix,
+                       const int fromYear, const int toYear) const;
+    int rangeTotal(const int* column, const vector<long long> RangeIndex::*prefix,
+                   const int fromYear, const int toYear) const;
+
+    string _name;                        // name of city
+    int _count;                          // number of years covered by the class
+    int _capacity;                       // number of years the owned columns have room for
+    char* _storage;                      // aligned block holding every column, if we own them
+    shared_ptr<const void> _backing;     // keeps borrowed columns alive otherwise
+    const int* _years;                   // CityYear::year column
+    const int* _daysBelow32;             // CityYear::numDaysBelow32 column
+    const int* _daysAbove90;             // CityYear::numDaysAbove90 column
+    const float* _averageTemperatures;   // CityYear::averageTemperature column
+    const float* _averageMaxes;          // CityYear::averageMax column
+    const float* _averageMins;           // CityYear::averageMin column
+    unique_ptr<RangeIndex> _rangeIndex;  // prefix sums, once buildRangeIndex() was called
+    double _sumAverageTemperature;       // running aggregates of the columns
+    int _totalDaysBelow32;
+    int _totalDaysAbove90;
+    float _allTimeMax;
+    float _allTimeMin;
   };
 }  // namespace csi281
 
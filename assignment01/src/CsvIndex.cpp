@@ -0,0 +1,196 @@
+//
+//  CsvIndex.cpp
+//
+//  Implementation of CsvIndex.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "CsvIndex.h"
+
+#include <algorithm>
+#include <cstring>  // for memchr() and memcpy()
+#include <fstream>
+#include <stdexcept>
+
+#include "csv.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  // first bytes of every saved index file, bumped whenever the layout changes
+  static const char INDEX_MAGIC[8] = {'C', 'S', 'V', 'I', 'D', 'X', '0', '1'};
+
+  template <typename T> static void writeValue(ofstream &out, const T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> static bool readValue(ifstream &in, T &value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+  }
+
+  static void writeString(ofstream &out, const string &text) {
+    writeValue(out, static_cast<uint32_t>(text.size()));
+    out.write(text.data(), text.size());
+  }
+
+  static bool readString(ifstream &in, string &text) {
+    uint32_t length;
+    if (!readValue(in, length) || length > (1u << 20)) return false;
+    text.resize(length);
+    return static_cast<bool>(in.read(text.data(), length));
+  }
+
+  CsvIndex::CsvIndex(const string &fileName, bool useSavedIndex)
+      : _file(fileName), _indexFileName(fileName + ".idx"), _loaded(false) {
+    if (useSavedIndex && load()) {
+      _loaded = true;
+    } else {
+      build();
+    }
+    indexStations();
+  }
+
+  // Record where every line starts and group the rows into STATION blocks
+  // in a single pass over the mapped bytes
+  void CsvIndex::build() {
+    const char *begin = _file.data();
+    const char *end = begin + _file.size();
+    const char *position = begin;
+    _offsets.clear();
+    _stations.clear();
+    for (int line = 0; position < end; line++) {
+      _offsets.push_back(position - begin);
+      const char *newline = static_cast<const char *>(memchr(position, '\n', end - position));
+      const char *lineEnd = newline == nullptr ? end : newline;
+      string_view rest(position, lineEnd - position);
+      if (line > 0 && rest.find_first_not_of(" \t\r") != string_view::npos) {
+        string_view station = nextCell(rest);
+        if (_stations.empty() || _stations.back().station != station) {
+          string_view name = nextCell(rest);
+          _stations.push_back({string(station), string(name), line, line});
+        } else {
+          _stations.back().endLine = line;
+        }
+      }
+      position = newline == nullptr ? end : newline + 1;
+    }
+    _offsets.push_back(_file.size());
+  }
+
+  // Hash of every byte of the file, so an edit anywhere (even one that keeps
+  // the size) makes a saved index stale. Eight bytes a step keeps it much
+  // cheaper than the scan that builds the index.
+  uint64_t CsvIndex::fingerprint() const {
+    const uint64_t PRIME = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a, a word at a time
+    const char *bytes = _file.data();
+    size_t size = _file.size(), i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, bytes + i, sizeof(word));
+      hash = (hash ^ word) * PRIME;
+      hash ^= hash >> 32;  // so high bytes of a word reach the low bits
+    }
+    for (; i < size; i++) hash = (hash ^ static_cast<unsigned char>(bytes[i])) * PRIME;
+    return hash ^ size;
+  }
+
+  // Write the index to indexFileName(), so the next run can skip the scan
+  void CsvIndex::save() const {
+    ofstream out(_indexFileName, ios::binary | ios::trunc);
+    if (!out) throw runtime_error("could not write " + _indexFileName);
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeValue(out, static_cast<uint64_t>(_file.size()));
+    writeValue(out, fingerprint());
+    writeValue(out, static_cast<uint64_t>(_offsets.size()));
+    out.write(reinterpret_cast<const char *>(_offsets.data()), _offsets.size() * sizeof(uint64_t));
+    writeValue(out, static_cast<uint64_t>(_stations.size()));
+    for (const StationBlock &block : _stations) {
+      writeString(out, block.station);
+      writeString(out, block.name);
+      writeValue(out, static_cast<int32_t>(block.startLine));
+      writeValue(out, static_cast<int32_t>(block.endLine));
+    }
+  }
+
+  // Load the saved index, returns false if it is missing, corrupt or was
+  // built for a different version of the CSV
+  bool CsvIndex::load() {
+    ifstream in(_indexFileName, ios::binary);
+    if (!in) return false;
+    char magic[sizeof(INDEX_MAGIC)];
+    uint64_t size, hash, numOffsets, numStations;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0
+        || !readValue(in, size) || size != _file.size() || !readValue(in, hash)
+        || hash != fingerprint() || !readValue(in, numOffsets) || numOffsets == 0
+        || numOffsets > _file.size() + 1) {
+      return false;
+    }
+    _offsets.resize(numOffsets);
+    if (!in.read(reinterpret_cast<char *>(_offsets.data()), numOffsets * sizeof(uint64_t))
+        || !is_sorted(_offsets.begin(), _offsets.end()) || _offsets.back() != _file.size()
+        || !readValue(in, numStations) || numStations > numOffsets) {
+      _offsets.clear();
+      return false;
+    }
+    _stations.resize(numStations);
+    for (StationBlock &block : _stations) {
+      int32_t startLine, endLine;
+      if (!readString(in, block.station) || !readString(in, block.name)
+          || !readValue(in, startLine) || !readValue(in, endLine) || startLine < 1
+          || endLine < startLine || endLine >= lineCount()) {
+        _offsets.clear();
+        _stations.clear();
+        return false;
+      }
+      block.startLine = startLine;
+      block.endLine = endLine;
+    }
+    return true;
+  }
+
+  // Hash every block by its STATION and NAME cells; where a cell is in more
+  // than one block, the first block keeps it, like a scan from the top would
+  void CsvIndex::indexStations() {
+    _stationLookup.clear();
+    _stationLookup.reserve(_stations.size() * 2);
+    for (size_t i = 0; i < _stations.size(); i++) {
+      _stationLookup.emplace(_stations[i].station, i);
+      _stationLookup.emplace(_stations[i].name, i);
+    }
+  }
+
+  // The bytes of a line without its line ending
+  string_view CsvIndex::line(const int line) const {
+    string_view text(_file.data() + _offsets[line], _offsets[line + 1] - _offsets[line]);
+    if (!text.empty() && text.back() == '\n') text.remove_suffix(1);
+    if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+    return text;
+  }
+
+  // Find a block by its STATION or NAME cell, nullptr if there is none
+  const StationBlock *CsvIndex::findStation(string_view stationOrName) const {
+    auto found = _stationLookup.find(string(stationOrName));
+    return found == _stationLookup.end() ? nullptr : &_stations[found->second];
+  }
+}  // namespace csi281
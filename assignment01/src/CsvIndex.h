@@ -0,0 +1,89 @@
+//
+//  CsvIndex.h
+//
+//  Line-offset and station index over a CSV file, so many cities can be
+//  loaded out of one mapped file without rescanning it for each of them.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef CsvIndex_hpp
+#define CsvIndex_hpp
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  // A run of consecutive lines that share the same STATION cell
+  struct StationBlock {
+    string station;  // STATION cell, e.g. USW00094728
+    string name;     // NAME cell, e.g. NY CITY CENTRAL PARK
+    int startLine;   // first line of the block
+    int endLine;     // last line of the block (inclusive)
+  };
+
+  // Byte offset of every line of a mapped CSV plus its STATION/NAME blocks.
+  // Lines are counted from 0, which is the header.
+  class CsvIndex {
+  public:
+    // Map fileName and load its saved index if there is an up to date one
+    // next to it, otherwise build the index with one pass over the file
+    explicit CsvIndex(const string &fileName, bool useSavedIndex = true);
+    // Write the index to indexFileName(), so the next run can skip the scan
+    void save() const;
+    // Whether the index was loaded from disk rather than built
+    bool wasLoaded() const { return _loaded; }
+    const string &indexFileName() const { return _indexFileName; }
+    const MappedFile &file() const { return _file; }
+    int lineCount() const { return static_cast<int>(_offsets.size()) - 1; }
+    uint64_t lineOffset(const int line) const { return _offsets[line]; }
+    string_view line(const int line) const;
+    const vector<StationBlock> &stations() const { return _stations; }
+    // Find a block by its STATION or NAME cell, nullptr if there is none.
+    // A hash lookup, so finding every station is linear in their number.
+    const StationBlock *findStation(string_view stationOrName) const;
+
+  private:
+    void build();
+    bool load();
+    void indexStations();
+    uint64_t fingerprint() const;
+
+    MappedFile _file;
+    string _indexFileName;
+    vector<uint64_t> _offsets;  // start of each line, then the file size
+    vector<StationBlock> _stations;
+    // STATION and NAME cells to the first of _stations that has them
+    unordered_map<string, size_t> _stationLookup;
+    bool _loaded;
+  };
+}  // namespace csi281
+
+#endif /* CsvIndex_hpp */
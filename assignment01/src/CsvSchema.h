@@ -0,0 +1,177 @@
+//
+//  CsvSchema.h
+//
+//  Compile-time description of how CSV columns map onto a record's fields.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef CsvSchema_hpp
+#define CsvSchema_hpp
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+#include "csv.h"
+
+using namespace std;
+
+namespace csi281 {
+  // The record and value type behind a pointer to a data member
+  template <typename T> struct MemberPointer;
+  template <typename R, typename V> struct MemberPointer<V R::*> {
+    using Record = R;
+    using Value = V;
+  };
+
+  // One field of a record and the header of the column it is read from
+  template <auto Member> struct Field {
+    static constexpr auto member = Member;
+    using Record = typename MemberPointer<decltype(Member)>::Record;
+    using Value = typename MemberPointer<decltype(Member)>::Value;
+    string_view column;
+  };
+
+  // field<&CityYear::year>("DATE")
+  template <auto Member> constexpr Field<Member> field(string_view column) { return {column}; }
+
+  // Parse one cell into a field, picked by the field's type at compile time
+  inline CellError parseCell(string_view cell, int &value) { return parseIntCell(cell, value); }
+  inline CellError parseCell(string_view cell, float &value) {
+    return parseFloatCell(cell, value);
+  }
+  inline CellError parseCell(string_view cell, string_view &value) {
+    value = cell;
+    return CellError::None;
+  }
+  inline CellError parseCell(string_view cell, string &value) {
+    value.assign(cell);
+    return CellError::None;
+  }
+
+  // Reads records whose fields are listed at compile time, e.g.
+  //   CsvSchema schema(field<&CityYear::year>("DATE"), field<&CityYear::averageMax>("TMAX"));
+  // resolve() finds each field's column in a header once; after that parse()
+  // only splits the line and calls the parser each field's type needs, so
+  // columns can come in any order (and unused ones are skipped) at no cost.
+  template <typename... Fields> class CsvSchema {
+  public:
+    using Record = typename tuple_element_t<0, tuple<Fields...>>::Record;
+    static_assert((is_same_v<typename Fields::Record, Record> && ...),
+                  "every field has to belong to the same record");
+    static constexpr size_t FIELD_COUNT = sizeof...(Fields);
+
+    constexpr CsvSchema(Fields... fields) : _headers{fields.column...} {}
+
+    // Find every field's column in a header line; throws runtime_error
+    // naming the first column that is missing, leaving the schema as it was
+    void resolve(string_view header) {
+      vector<int> slots;
+      array<bool, FIELD_COUNT> found{};
+      for (int column = 0; !header.empty(); column++) {
+        string_view name = nextCell(header);
+        for (size_t f = 0; f < FIELD_COUNT; f++) {
+          if (!found[f] && name == _headers[f]) {
+            slots.resize(column + 1, NOT_READ);
+            slots[column] = static_cast<int>(f);
+            found[f] = true;
+            break;
+          }
+        }
+      }
+      for (size_t f = 0; f < FIELD_COUNT; f++) {
+        if (!found[f]) throw runtime_error("no column named " + string(_headers[f]));
+      }
+      _slots = std::move(slots);
+    }
+
+    // Parse one line (without its newline) into record and give back the
+    // error of the first field that couldn't be parsed (columns missing from
+    // a short line count as empty cells). Fields after that one are left alone.
+    CellError parse(string_view line, Record &record) const {
+      array<string_view, FIELD_COUNT> cells{};
+      for (size_t column = 0; column < _slots.size(); column++) {
+        string_view cell = nextCell(line);
+        if (_slots[column] != NOT_READ) cells[_slots[column]] = cell;
+      }
+      return parseFields(cells, record, index_sequence_for<Fields...>());
+    }
+
+    bool resolved() const { return !_slots.empty(); }
+
+  private:
+    static constexpr int NOT_READ = -1;
+
+    // A fold over the fields; && stops at the first one that fails
+    template <size_t... I>
+    static CellError parseFields(const array<string_view, FIELD_COUNT> &cells, Record &record,
+                                 index_sequence<I...>) {
+      CellError error = CellError::None;
+      (void)(... && ((error = parseCell(cells[I], record.*(Fields::member))) == CellError::None));
+      return error;
+    }
+
+    array<string_view, FIELD_COUNT> _headers;
+    vector<int> _slots;  // for each column up to the last one needed, the field it fills
+  };
+
+  // Read every line after the header of a CSV with schema, one record per
+  // line (quoted cells can't span lines here); throws
+  // runtime_error on missing columns and invalid_argument on bad cells
+  template <typename... Fields>
+  vector<typename CsvSchema<Fields...>::Record> readRecords(string_view csv,
+                                                           CsvSchema<Fields...> schema) {
+    size_t newline = csv.find('\n');
+    schema.resolve(csv.substr(0, newline));
+    csv.remove_prefix(newline == string_view::npos ? csv.size() : newline + 1);
+
+    vector<typename CsvSchema<Fields...>::Record> records;
+    while (!csv.empty()) {
+      newline = csv.find('\n');
+      string_view line = csv.substr(0, newline);
+      csv.remove_prefix(newline == string_view::npos ? csv.size() : newline + 1);
+      if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+      if (line.empty()) continue;
+      records.emplace_back();
+      if (schema.parse(line, records.back()) != CellError::None) {
+        throw invalid_argument("bad cell in line: " + string(line));
+      }
+    }
+    return records;
+  }
+
+  // The schema of tempdata.csv
+  inline auto cityYearSchema() {
+    return CsvSchema(field<&CityYear::year>("DATE"), field<&CityYear::numDaysBelow32>("DX32"),
+                     field<&CityYear::numDaysAbove90>("DX90"),
+                     field<&CityYear::averageTemperature>("TAVG"),
+                     field<&CityYear::averageMax>("TMAX"), field<&CityYear::averageMin>("TMIN"));
+  }
+}  // namespace csi281
+
+#endif /* CsvSchema_hpp */
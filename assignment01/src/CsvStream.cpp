@@ -0,0 +1,144 @@
+//
+//  CsvStream.cpp
+//
+//  Implementation of the streaming CSV reader.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "CsvStream.h"
+
+#include <algorithm>  // for count()
+#include <cerrno>
+#include <cstring>  // for memchr() and memmove()
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include "csv.h"
+
+using namespace std;
+
+namespace csi281 {
+  CsvStream::CsvStream(istream &in, size_t maxRows, size_t bufferBytes)
+      : _in(&in), _fd(-1), _maxRows(max<size_t>(maxRows, 1)), _buffer(bufferBytes), _begin(0),
+        _end(0) {}
+
+  CsvStream::CsvStream(int fd, size_t maxRows, size_t bufferBytes)
+      : _in(nullptr), _fd(fd), _maxRows(max<size_t>(maxRows, 1)), _buffer(bufferBytes), _begin(0),
+        _end(0) {}
+
+  bool CsvStream::refill() {
+    memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+    _end -= _begin;
+    _begin = 0;
+    if (_end == _buffer.size()) throw length_error("CSV record is longer than the stream buffer");
+
+    char *free = _buffer.data() + _end;
+    size_t room = _buffer.size() - _end;
+    long long bytes;
+    if (_in != nullptr) {
+      _in->read(free, static_cast<streamsize>(room));
+      bytes = _in->gcount();
+    } else {
+      do {
+#ifdef _WIN32
+        bytes = _read(_fd, free, static_cast<unsigned>(room));
+#else
+        bytes = ::read(_fd, free, room);
+#endif
+      } while (bytes < 0 && errno == EINTR);
+      if (bytes < 0) throw system_error(errno, generic_category(), "reading CSV stream");
+    }
+    _end += static_cast<size_t>(bytes);
+    return bytes > 0;
+  }
+
+  size_t CsvStream::readAll(const BatchCallback &onBatch) {
+    vector<CityYear> batch;
+    batch.reserve(_maxRows);
+    string station, name;
+    auto flush = [&] {
+      if (!batch.empty()) onBatch(station, name, batch);
+      batch.clear();
+    };
+
+    size_t rows = 0;
+    bool header = true;
+    bool atEnd = false;
+    size_t scanned = _begin;  // bytes of the current record already looked at
+    bool quoted = false;      // whether scanned stopped inside quotes
+    while (true) {
+      // look for the first newline outside quotes, refilling until there is one
+      const char *data = _buffer.data();
+      const char *newline = nullptr;
+      while (scanned < _end) {
+        const char *found
+            = static_cast<const char *>(memchr(data + scanned, '\n', _end - scanned));
+        const char *stop = found == nullptr ? data + _end : found;
+        quoted ^= count(data + scanned, stop, '"') % 2 == 1;
+        scanned = stop - data;
+        if (found == nullptr) break;
+        if (!quoted) {
+          newline = found;
+          break;
+        }
+        scanned++;  // a quoted newline is part of the cell
+      }
+      if (newline == nullptr && !atEnd) {
+        size_t consumed = _begin;
+        atEnd = !refill();
+        scanned -= consumed;
+        continue;
+      }
+      if (newline == nullptr && _begin == _end) break;
+
+      size_t recordEnd = newline == nullptr ? _end : newline - data;
+      string_view record(data + _begin, recordEnd - _begin);
+      _begin = scanned = newline == nullptr ? _end : recordEnd + 1;
+      quoted = false;
+      if (header) {
+        header = false;
+        continue;
+      }
+      if (record.find_first_not_of(" \t\r") == string_view::npos) continue;
+
+      string_view cells = record;
+      string_view recordStation = nextCell(cells);
+      if (recordStation != station || batch.size() == _maxRows) {
+        flush();
+        if (recordStation != station) {
+          station.assign(recordStation);
+          name.assign(nextCell(cells));
+        }
+      }
+      batch.push_back(parseLine(record));
+      rows++;
+    }
+    flush();
+    return rows;
+  }
+}  // namespace csi281
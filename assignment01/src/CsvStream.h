@@ -0,0 +1,73 @@
+//
+//  CsvStream.h
+//
+//  Reads temperature CSVs from pipes and other streams in bounded memory.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef CsvStream_hpp
+#define CsvStream_hpp
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "CityTemperatureData.h"
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+  // Reads a CSV in the tempdata.csv schema front to back from an istream or
+  // a file descriptor, so it works on pipes and other unseekable input. The
+  // bytes go through one fixed-size buffer and the rows are handed out in
+  // batches, so memory use doesn't grow with the input.
+  class CsvStream {
+  public:
+    // Gets one station's rows at a time, at most maxRows of them; a station
+    // with more rows than that arrives in several batches in a row
+    using BatchCallback = function<void(const string &station, const string &name,
+                                        const vector<CityYear> &years)>;
+
+    explicit CsvStream(istream &in, size_t maxRows = 4096, size_t bufferBytes = 1 << 16);
+    explicit CsvStream(int fd, size_t maxRows = 4096, size_t bufferBytes = 1 << 16);
+
+    // Read everything left, skipping the header, and give back how many rows
+    // were read. A record longer than the buffer throws length_error; bad
+    // cells throw like readCity() does, and so does a failing descriptor.
+    size_t readAll(const BatchCallback &onBatch);
+
+  private:
+    // Move the unread bytes to the front and read after them; false at the end
+    bool refill();
+
+    istream *_in;
+    int _fd;
+    size_t _maxRows;
+    vector<char> _buffer;
+    size_t _begin;  // first byte not handed out yet
+    size_t _end;    // one past the last byte read
+  };
+}  // namespace csi281
+
+#endif /* CsvStream_hpp */
@@ -0,0 +1,158 @@
+//
+//  MappedFile.cpp
+//
+//  Implementation of MappedFile on top of mmap() or, on Windows,
+//  CreateFileMapping().
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace csi281 {
+
+#ifdef _WIN32
+  MappedFile::MappedFile(const string &fileName)
+      : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) {
+    _file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) {
+      throw runtime_error("could not open " + fileName);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(_file, &fileSize)) {
+      release();
+      throw runtime_error("could not stat " + fileName);
+    }
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    if (_size == 0) return;  // nothing to map
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping == nullptr) {
+      release();
+      throw runtime_error("could not map " + fileName);
+    }
+    _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr) {
+      release();
+      throw runtime_error("could not map " + fileName);
+    }
+  }
+
+  void MappedFile::release() {
+    if (_data != nullptr) UnmapViewOfFile(_data);
+    if (_mapping != nullptr) CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+  }
+
+  MappedFile::MappedFile(MappedFile &&other) noexcept
+      : _data(other._data), _size(other._size), _file(other._file), _mapping(other._mapping) {
+    other._data = nullptr;
+    other._size = 0;
+    other._file = INVALID_HANDLE_VALUE;
+    other._mapping = nullptr;
+  }
+
+  MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      release();
+      _data = other._data;
+      _size = other._size;
+      _file = other._file;
+      _mapping = other._mapping;
+      other._data = nullptr;
+      other._size = 0;
+      other._file = INVALID_HANDLE_VALUE;
+      other._mapping = nullptr;
+    }
+    return *this;
+  }
+#else
+  MappedFile::MappedFile(const string &fileName) : _data(nullptr), _size(0) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw runtime_error("could not open " + fileName);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      throw runtime_error("could not stat " + fileName);
+    }
+    _size = static_cast<size_t>(info.st_size);
+    if (_size == 0) {  // mmap() refuses empty mappings
+      close(fd);
+      return;
+    }
+    void *mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps its own reference to the file
+    if (mapped == MAP_FAILED) {
+      _size = 0;
+      throw runtime_error("could not map " + fileName);
+    }
+    // the readers walk the file front to back, so let the kernel read ahead
+    madvise(mapped, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char *>(mapped);
+  }
+
+  void MappedFile::release() {
+    if (_data != nullptr) munmap(const_cast<char *>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+  }
+
+  MappedFile::MappedFile(MappedFile &&other) noexcept : _data(other._data), _size(other._size) {
+    other._data = nullptr;
+    other._size = 0;
+  }
+
+  MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      release();
+      _data = other._data;
+      _size = other._size;
+      other._data = nullptr;
+      other._size = 0;
+    }
+    return *this;
+  }
+#endif
+
+  MappedFile::~MappedFile() { release(); }
+}  // namespace csi281
@@ -0,0 +1,67 @@
+//
+//  MappedFile.h
+//
+//  Read-only memory mapping of a file, so the CSV readers can parse
+//  straight out of the page cache without copying lines around.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  // Maps a whole file read-only into memory for as long as the object lives.
+  // Throws runtime_error if the file can't be opened or mapped.
+  class MappedFile {
+  public:
+    explicit MappedFile(const string &fileName);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    string_view view() const { return string_view(_data, _size); }
+
+  private:
+    void release();
+
+    const char *_data;  // first mapped byte, nullptr for an empty file
+    size_t _size;       // number of mapped bytes
+#ifdef _WIN32
+    void *_file;     // HANDLE of the open file
+    void *_mapping;  // HANDLE of the file mapping object
+#endif
+  };
+}  // namespace csi281
+
+#endif /* MappedFile_hpp */
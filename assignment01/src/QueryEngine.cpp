@@ -0,0 +1,75 @@
+//
+//  QueryEngine.cpp
+//
+//  Implementation of the non-template parts of the query engine.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "QueryEngine.h"
+
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace csi281 {
+  CityList cityList(const CityMap &cities) {
+    CityList list;
+    list.reserve(cities.size());
+    for (const auto &[station, city] : cities) list.push_back(city.get());
+    return list;
+  }
+
+  const int *columnOf(const CityTemperatureData &city, int CityYear::*field) {
+    if (field == &CityYear::year) return city.years();
+    if (field == &CityYear::numDaysBelow32) return city.daysBelow32();
+    if (field == &CityYear::numDaysAbove90) return city.daysAbove90();
+    throw invalid_argument("not a CityYear field");
+  }
+
+  const float *columnOf(const CityTemperatureData &city, float CityYear::*field) {
+    if (field == &CityYear::averageTemperature) return city.averageTemperatures();
+    if (field == &CityYear::averageMax) return city.averageMaxes();
+    if (field == &CityYear::averageMin) return city.averageMins();
+    throw invalid_argument("not a CityYear field");
+  }
+
+  // Years are consecutive, so x is just the index and its mean and spread
+  // have closed forms. Fewer than two years give no slope at all, rather
+  // than a flat one.
+  template <typename T> static double slope(const T *values, const int count) {
+    if (count < 2) return numeric_limits<double>::quiet_NaN();
+    double meanX = (count - 1) / 2.0;
+    double sumY = 0, sumXY = 0;
+    for (int i = 0; i < count; i++) {
+      sumY += values[i];
+      sumXY += i * static_cast<double>(values[i]);
+    }
+    double covariance = sumXY - meanX * sumY;
+    double varianceX = static_cast<double>(count) * (static_cast<double>(count) * count - 1) / 12;
+    return covariance / varianceX;
+  }
+
+  double trendOf(const int *values, const int count) { return slope(values, count); }
+
+  double trendOf(const float *values, const int count) { return slope(values, count); }
+}  // namespace csi281
@@ -0,0 +1,212 @@
+//
+//  QueryEngine.h
+//
+//  Filters and top-k rankings over many cities, evaluated in parallel.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef QueryEngine_hpp
+#define QueryEngine_hpp
+
+#include <algorithm>
+#include <cmath>  // for isnan()
+#include <functional>
+#include <future>
+#include <limits>
+#include <vector>
+
+#include "CityTemperatureData.h"
+#include "MemoryLeakDetector.h"
+#include "ThreadPool.h"
+#include "csv.h"
+
+using namespace std;
+
+namespace csi281 {
+  // The cities a query runs over
+  using CityList = vector<const CityTemperatureData *>;
+
+  // The cities of a CityMap, in station order
+  CityList cityList(const CityMap &cities);
+
+  // The column of city holding a CityYear field, e.g. &CityYear::averageMax
+  const int *columnOf(const CityTemperatureData &city, int CityYear::*field);
+  const float *columnOf(const CityTemperatureData &city, float CityYear::*field);
+
+  // Least squares slope of a column against the year, in units per year;
+  // NaN for fewer than two years
+  double trendOf(const int *values, const int count);
+  double trendOf(const float *values, const int count);
+
+  // Projections: turn a city into a number to rank by, NaN if there is
+  // nothing to rank it by (like largest() of a city without years, or the
+  // trend() of one with fewer than two)
+  template <typename T> auto trend(T CityYear::*field) {
+    return [field](const CityTemperatureData &city) {
+      return trendOf(columnOf(city, field), city.count());
+    };
+  }
+
+  template <typename T> auto largest(T CityYear::*field) {
+    return [field](const CityTemperatureData &city) {
+      if (city.count() == 0) return numeric_limits<double>::quiet_NaN();
+      const T *column = columnOf(city, field);
+      return static_cast<double>(*max_element(column, column + city.count()));
+    };
+  }
+
+  // Predicates: true for a city if yearPredicate holds for any (or every) year
+  template <typename YearPredicate> auto anyYear(YearPredicate yearPredicate) {
+    return [yearPredicate](const CityTemperatureData &city) {
+      for (int i = 0; i < city.count(); i++) {
+        if (yearPredicate(city[city.getFirstYear() + i])) return true;
+      }
+      return false;
+    };
+  }
+
+  template <typename YearPredicate> auto everyYear(YearPredicate yearPredicate) {
+    return [yearPredicate](const CityTemperatureData &city) {
+      for (int i = 0; i < city.count(); i++) {
+        if (!yearPredicate(city[city.getFirstYear() + i])) return false;
+      }
+      return true;
+    };
+  }
+
+  // Keeps the k best items offered to it, where better(a, b) means a ranks
+  // above b. The worst of those kept sits at the top of a heap, so each offer
+  // is O(log k) and nothing beyond k items is ever stored. Room is set aside
+  // up front for k items, or for maxOffers if fewer than that will come.
+  template <typename T, typename Better> class TopK {
+  public:
+    TopK(size_t k, Better better, size_t maxOffers = numeric_limits<size_t>::max())
+        : _k(k), _better(better) {
+      _heap.reserve(min(k, maxOffers));
+    }
+
+    void offer(const T &item) {
+      if (_k == 0) return;
+      if (_heap.size() < _k) {
+        _heap.push_back(item);
+        push_heap(_heap.begin(), _heap.end(), _better);
+      } else if (_better(item, _heap.front())) {
+        pop_heap(_heap.begin(), _heap.end(), _better);
+        _heap.back() = item;
+        push_heap(_heap.begin(), _heap.end(), _better);
+      }
+    }
+
+    // Fold in what another TopK kept
+    void merge(const TopK &other) {
+      for (const T &item : other._heap) offer(item);
+    }
+
+    // The items kept, best first
+    vector<T> sorted() const {
+      vector<T> items = _heap;
+      sort(items.begin(), items.end(), _better);
+      return items;
+    }
+
+  private:
+    size_t _k;
+    Better _better;
+    vector<T> _heap;
+  };
+
+  // A city and the value a projection gave it
+  struct RankedCity {
+    const CityTemperatureData *city;
+    double value;
+    size_t index;  // position in the list queried, to break ties the same way every run
+  };
+
+  // Run work(first, last) over [0, count) split into a few chunks per thread
+  // and collect what each chunk returned, in order
+  template <typename Work>
+  auto forEachChunk(size_t count, ThreadPool &pool, Work work) -> vector<decltype(work(0, 0))> {
+    size_t chunks = min(count, static_cast<size_t>(pool.size()) * 4);
+    vector<future<decltype(work(0, 0))>> pending;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+      size_t first = count * chunk / chunks, last = count * (chunk + 1) / chunks;
+      pending.push_back(pool.submit([=] { return work(first, last); }));
+    }
+    for (auto &result : pending) result.wait();  // so nothing still runs if a get() throws
+    vector<decltype(work(0, 0))> results;
+    for (auto &result : pending) results.push_back(result.get());
+    return results;
+  }
+
+  // The cities for which predicate(city) is true, in the order given
+  template <typename Predicate>
+  CityList filterCities(const CityList &cities, Predicate predicate, ThreadPool &pool) {
+    auto chunks = forEachChunk(cities.size(), pool, [&](size_t first, size_t last) {
+      CityList matches;
+      for (size_t i = first; i < last; i++) {
+        if (predicate(*cities[i])) matches.push_back(cities[i]);
+      }
+      return matches;
+    });
+    CityList matches;
+    for (const auto &chunk : chunks) matches.insert(matches.end(), chunk.begin(), chunk.end());
+    return matches;
+  }
+
+  // The k cities with the largest projection(city), largest first; cities
+  // it gives NaN are left out. Every chunk keeps its own bounded TopK and
+  // those are merged at the end.
+  template <typename Projection>
+  vector<RankedCity> topCities(const CityList &cities, size_t k, Projection projection,
+                               ThreadPool &pool) {
+    auto better = [](const RankedCity &a, const RankedCity &b) {
+      return a.value != b.value ? a.value > b.value : a.index < b.index;
+    };
+    using Ranking = TopK<RankedCity, decltype(better)>;
+    auto chunks = forEachChunk(cities.size(), pool, [&](size_t first, size_t last) {
+      Ranking best(k, better, last - first);
+      for (size_t i = first; i < last; i++) {
+        double value = projection(*cities[i]);
+        if (!isnan(value)) best.offer({cities[i], value, i});
+      }
+      return best;
+    });
+    Ranking best(k, better, cities.size());
+    for (const Ranking &chunk : chunks) best.merge(chunk);
+    return best.sorted();
+  }
+
+  // The same queries on a pool made just for them
+  template <typename Predicate>
+  CityList filterCities(const CityList &cities, Predicate predicate) {
+    ThreadPool pool;
+    return filterCities(cities, predicate, pool);
+  }
+
+  template <typename Projection>
+  vector<RankedCity> topCities(const CityList &cities, size_t k, Projection projection) {
+    ThreadPool pool;
+    return topCities(cities, k, projection, pool);
+  }
+}  // namespace csi281
+
+#endif /* QueryEngine_hpp */
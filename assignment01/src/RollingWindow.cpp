@@ -0,0 +1,122 @@
+//
+//  RollingWindow.cpp
+//
+//  Implementation of the rolling-window engine.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RollingWindow.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace csi281 {
+  // Copy a column out as floats, whatever its type
+  template <typename T> static vector<float> widen(const T* values, const int count) {
+    return vector<float>(values, values + count);
+  }
+
+  static vector<float> columnValues(const CityTemperatureData& city, const CityColumn column) {
+    switch (column) {
+      case CityColumn::DaysBelow32:
+        return widen(city.daysBelow32(), city.count());
+      case CityColumn::DaysAbove90:
+        return widen(city.daysAbove90(), city.count());
+      case CityColumn::AverageTemperature:
+        return widen(city.averageTemperatures(), city.count());
+      case CityColumn::AverageMax:
+        return widen(city.averageMaxes(), city.count());
+      case CityColumn::AverageMin:
+        return widen(city.averageMins(), city.count());
+    }
+    throw invalid_argument("unknown column");
+  }
+
+  // Indices of the candidates for a window's min or max, best at the front.
+  // Every index is pushed at most once, so a plain array of count() slots is
+  // enough and nothing is allocated while sliding.
+  struct MonotonicDeque {
+    vector<int> slots;
+    int head = 0;
+    int tail = 0;
+  };
+
+  // Slide the deque for one window along by index i; better(a, b) is true
+  // when a should be kept over b
+  template <typename Better>
+  static void slide(MonotonicDeque& deque, const vector<float>& values, const int i,
+                    const int window, Better better) {
+    while (deque.tail > deque.head && !better(values[deque.slots[deque.tail - 1]], values[i])) {
+      deque.tail--;
+    }
+    deque.slots[deque.tail++] = i;
+    if (deque.slots[deque.head] <= i - window) deque.head++;
+  }
+
+  vector<RollingSeries> rollingWindows(const CityTemperatureData& city, const CityColumn column,
+                                       const vector<int>& windows) {
+    const int count = city.count();
+    vector<float> values = columnValues(city, column);
+
+    // one prefix sum serves the mean of every window size
+    vector<double> prefix(count + 1, 0.0);
+    for (int i = 0; i < count; i++) prefix[i + 1] = prefix[i] + values[i];
+
+    vector<RollingSeries> results(windows.size());
+    vector<MonotonicDeque> minimums(windows.size());
+    vector<MonotonicDeque> maximums(windows.size());
+    for (size_t w = 0; w < windows.size(); w++) {
+      int window = windows[w];
+      if (window < 1) throw invalid_argument("window sizes have to be at least 1");
+      int length = max(count - window + 1, 0);
+      results[w].window = window;
+      results[w].mean.resize(length);
+      results[w].min.resize(length);
+      results[w].max.resize(length);
+      minimums[w].slots.resize(count);
+      maximums[w].slots.resize(count);
+
+      // independent differences, so this loop vectorizes
+      float* mean = results[w].mean.data();
+      const double* ends = prefix.data() + window;
+      for (int i = 0; i < length; i++) {
+        mean[i] = static_cast<float>((ends[i] - prefix[i]) / window);
+      }
+    }
+
+    // a single pass over the years moves every window's deques along
+    for (int i = 0; i < count; i++) {
+      for (size_t w = 0; w < windows.size(); w++) {
+        int window = windows[w];
+        slide(minimums[w], values, i, window, [](float a, float b) { return a < b; });
+        slide(maximums[w], values, i, window, [](float a, float b) { return a > b; });
+        int start = i - window + 1;
+        if (start >= 0) {
+          results[w].min[start] = values[minimums[w].slots[minimums[w].head]];
+          results[w].max[start] = values[maximums[w].slots[maximums[w].head]];
+        }
+      }
+    }
+    return results;
+  }
+}  // namespace csi281
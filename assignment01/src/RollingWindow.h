@@ -0,0 +1,60 @@
+//
+//  RollingWindow.h
+//
+//  Sliding mean, min and max over a CityTemperatureData column,
+//  for many window sizes at once.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef RollingWindow_hpp
+#define RollingWindow_hpp
+
+#include <vector>
+
+#include "CityTemperatureData.h"
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+  // The numeric columns of CityTemperatureData
+  enum class CityColumn { DaysBelow32, DaysAbove90, AverageTemperature, AverageMax, AverageMin };
+
+  // One window size worth of results. Entry i covers the years
+  // getFirstYear() + i through getFirstYear() + i + window - 1, so there are
+  // count() - window + 1 entries (none if the window is longer than the data).
+  struct RollingSeries {
+    int window;
+    vector<float> mean;
+    vector<float> min;
+    vector<float> max;
+  };
+
+  // Slide every window in windows over column in one pass over the years.
+  // The means all come from one shared prefix sum and the mins and maxes
+  // from a monotonic deque per window, so each window is O(n) regardless of
+  // its size. Windows have to be at least 1 (invalid_argument otherwise).
+  vector<RollingSeries> rollingWindows(const CityTemperatureData& city, const CityColumn column,
+                                       const vector<int>& windows);
+}  // namespace csi281
+
+#endif /* RollingWindow_hpp */
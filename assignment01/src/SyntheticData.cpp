@@ -0,0 +1,93 @@
+//
+//  SyntheticData.cpp
+//
+//  Implementation of the synthetic data generator.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "SyntheticData.h"
+
+#include <algorithm>  // for min() and max()
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+namespace csi281 {
+  static const char *PLACES[]
+      = {"BURLINGTON", "NY CITY", "ALBANY", "RUTLAND", "PORTLAND", "ST. PAUL", "MONTPELIER"};
+  static const char *KINDS[] = {"INTERNATIONAL AIRPORT", "CENTRAL PARK", "MUNICIPAL AIRPORT",
+                                "WSO", "2 NE"};
+  static const char *STATES[] = {"VT", "NY", "ME", "MN", "MA", "NH"};
+  static const size_t FLUSH_BYTES = 1 << 20;
+
+  template <typename T, size_t N> static const T &pick(const T (&choices)[N], mt19937 &gen) {
+    return choices[gen() % N];
+  }
+
+  uintmax_t writeSyntheticData(const string &fileName, const SyntheticOptions &options) {
+    FILE *file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr) throw runtime_error("could not write " + fileName);
+
+    mt19937 gen(options.seed);
+    normal_distribution<float> climate(52.0f, 8.0f);  // each station's typical year
+    normal_distribution<float> weather(0.0f, 1.2f);   // one year's deviation from it
+    uniform_int_distribution<> nicknames(0, 9);
+
+    string buffer = "\"STATION\",\"NAME\",\"DATE\",\"DX32\",\"DX90\",\"TAVG\",\"TMAX\",\"TMIN\"\n";
+    uintmax_t written = 0;
+    char name[96];
+    char line[224];
+    for (long long station = 0; station < options.stations; station++) {
+      if (options.punctuatedNames) {
+        const char *nickname = nicknames(gen) == 0 ? " \"\"THE FLATS\"\"" : "";
+        snprintf(name, sizeof(name), "%s %s%s, %s US", pick(PLACES, gen), pick(KINDS, gen),
+                 nickname, pick(STATES, gen));
+      } else {
+        snprintf(name, sizeof(name), "SYNTHETIC STATION %lld", station);
+      }
+      float normal = climate(gen);
+      for (int i = 0; i < options.yearsPerStation; i++) {
+        float average = normal + weather(gen);
+        float range = 7.5f + weather(gen);
+        // colder places freeze more often and bake less
+        int below32 = max(0, static_cast<int>(4.0f * (60.0f - average) + 10.0f * weather(gen)));
+        int above90 = max(0, static_cast<int>(3.0f * (average - 42.0f) + 5.0f * weather(gen)));
+        snprintf(line, sizeof(line),
+                 "\"USW%08lld\",\"%s\",\"%d\",\"%d\",\"%d\",\"%.1f\",\"%.1f\",\"%.1f\"\n", station,
+                 name, options.firstYear + i, min(below32, 365), min(above90, 365), average,
+                 average + range, average - range);
+        buffer += line;
+        if (buffer.size() >= FLUSH_BYTES) {
+          written += fwrite(buffer.data(), 1, buffer.size(), file);
+          buffer.clear();
+        }
+      }
+    }
+    written += fwrite(buffer.data(), 1, buffer.size(), file);
+    bool failed = ferror(file) != 0;
+    failed |= fclose(file) != 0;
+    if (failed) throw runtime_error("could not write " + fileName);
+    return written;
+  }
+}  // namespace csi281
@@ -0,0 +1,56 @@
+//
+//  SyntheticData.h
+//
+//  Generates temperature CSVs of any size in the tempdata.csv schema,
+//  for benchmarks and tests.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SyntheticData_hpp
+#define SyntheticData_hpp
+
+#include <cstdint>
+#include <string>
+
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+  struct SyntheticOptions {
+    long long stations = 1000;  // each gets its own STATION id and NAME
+    int yearsPerStation = 60;   // consecutive years, one row each
+    int firstYear = 1960;
+    unsigned seed = 281;  // the same options always write the same file
+    // Name stations like NOAA does, "SOMEWHERE AIRPORT, VT US", with the odd
+    // ""nickname"" in doubled quotes. Only the quote-aware readers handle
+    // these; readLine() splits on every comma.
+    bool punctuatedNames = true;
+  };
+
+  // Write a CSV with options.stations * options.yearsPerStation rows after the
+  // header, grouped by station like tempdata.csv. Returns the size of the file
+  // in bytes; throws runtime_error if it can't be written.
+  uintmax_t writeSyntheticData(const string &fileName, const SyntheticOptions &options = {});
+}  // namespace csi281
+
+#endif /* SyntheticData_hpp */
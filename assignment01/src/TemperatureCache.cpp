@@ -0,0 +1,186 @@
+//
+//  TemperatureCache.cpp
+//
+//  Implementation of the binary columnar cache.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "TemperatureCache.h"
+
+#include <cstring>  // for memcmp()
+#include <fstream>
+#include <stdexcept>
+
+#include "CsvIndex.h"
+#include "csv.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  static const char CACHE_MAGIC[8] = {'C', 'S', 'I', '2', '8', '1', 'T', 'C'};
+  static const uint32_t CACHE_BYTE_ORDER = 0x01020304;
+  static const uint32_t CACHE_VERSION = 1;
+  static const uint64_t CACHE_ALIGNMENT = 64;
+
+  // the format is written and read with plain struct copies
+  static_assert(sizeof(CacheHeader) == 40 && sizeof(CacheStation) == 48, "unexpected padding");
+  static_assert(sizeof(int) == 4 && sizeof(float) == 4, "columns are 32 bits wide");
+
+  static uint64_t alignUp(uint64_t offset) {
+    return (offset + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+  }
+
+  // Write cities to fileName in the cache format, storing stations[i] and
+  // each city's name as its STATION and NAME
+  void writeTemperatureCache(const string &fileName,
+                             const vector<const CityTemperatureData *> &cities,
+                             const vector<string> &stations) {
+    if (cities.size() != stations.size()) {
+      throw invalid_argument("every city needs a station");
+    }
+
+    // lay the file out first, so everything can be written in one go
+    CacheHeader header = {};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.byteOrder = CACHE_BYTE_ORDER;
+    header.version = CACHE_VERSION;
+    header.numStations = static_cast<uint32_t>(cities.size());
+    header.stationTableOffset = sizeof(CacheHeader);
+    vector<CacheStation> table(cities.size());
+    uint64_t offset = header.stationTableOffset + table.size() * sizeof(CacheStation);
+    for (size_t i = 0; i < cities.size(); i++) {
+      table[i].stationOffset = offset;
+      table[i].stationLength = static_cast<uint32_t>(stations[i].size());
+      offset += stations[i].size();
+      table[i].nameOffset = offset;
+      table[i].nameLength = static_cast<uint32_t>(cities[i]->getName().size());
+      offset += cities[i]->getName().size();
+    }
+    for (size_t i = 0; i < cities.size(); i++) {
+      table[i].numYears = cities[i]->count();
+      table[i].firstYear = cities[i]->count() > 0 ? cities[i]->getFirstYear() : 0;
+      table[i].columnStride = alignUp(cities[i]->count() * sizeof(int));
+      table[i].columnsOffset = offset = alignUp(offset);
+      offset += 6 * table[i].columnStride;
+    }
+    header.fileSize = offset;
+
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out) throw runtime_error("could not write " + fileName);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(CacheStation));
+    for (size_t i = 0; i < cities.size(); i++) {
+      out.write(stations[i].data(), stations[i].size());
+      out.write(cities[i]->getName().data(), cities[i]->getName().size());
+    }
+    const char padding[CACHE_ALIGNMENT] = {};
+    for (size_t i = 0; i < cities.size(); i++) {
+      const CityTemperatureData &city = *cities[i];
+      const void *columns[6] = {city.years(),
+                                city.daysBelow32(),
+                                city.daysAbove90(),
+                                city.averageTemperatures(),
+                                city.averageMaxes(),
+                                city.averageMins()};
+      out.write(padding, table[i].columnsOffset - static_cast<uint64_t>(out.tellp()));
+      for (const void *column : columns) {
+        size_t bytes = city.count() * sizeof(int);
+        out.write(static_cast<const char *>(column), bytes);
+        out.write(padding, table[i].columnStride - bytes);
+      }
+    }
+    if (!out) throw runtime_error("could not write " + fileName);
+  }
+
+  // Convert every STATION block of a CSV into a cache file
+  void convertCsvToCache(const string &csvFileName, const string &cacheFileName) {
+    CsvIndex index(csvFileName);
+    vector<const CityTemperatureData *> cities;
+    vector<string> stations;
+    try {
+      for (const StationBlock &block : index.stations()) {
+        cities.push_back(readCity(block.name, index, block));
+        stations.push_back(block.station);
+      }
+      writeTemperatureCache(cacheFileName, cities, stations);
+    } catch (...) {
+      for (const CityTemperatureData *city : cities) delete city;
+      throw;
+    }
+    for (const CityTemperatureData *city : cities) delete city;
+  }
+
+  // Map the file and check that every offset in it stays inside it
+  TemperatureCache::TemperatureCache(const string &fileName)
+      : _file(make_shared<const MappedFile>(fileName)) {
+    uint64_t size = _file->size();
+    _header = reinterpret_cast<const CacheHeader *>(_file->data());
+    if (size < sizeof(CacheHeader) || memcmp(_header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || _header->byteOrder != CACHE_BYTE_ORDER || _header->version != CACHE_VERSION
+        || _header->fileSize != size || _header->stationTableOffset % alignof(CacheStation) != 0
+        || _header->stationTableOffset + _header->numStations * sizeof(CacheStation) > size) {
+      throw runtime_error(fileName + " is not a temperature cache");
+    }
+    _stations = reinterpret_cast<const CacheStation *>(_file->data() + _header->stationTableOffset);
+    for (int i = 0; i < stationCount(); i++) {
+      const CacheStation &entry = _stations[i];
+      if (entry.stationOffset + entry.stationLength > size
+          || entry.nameOffset + entry.nameLength > size || entry.numYears < 0
+          || entry.columnsOffset % CACHE_ALIGNMENT != 0
+          || entry.columnStride < entry.numYears * sizeof(int)
+          || entry.columnsOffset + 6 * entry.columnStride > size) {
+        throw runtime_error(fileName + " is corrupt");
+      }
+    }
+  }
+
+  string_view TemperatureCache::station(const int index) const {
+    return string_view(_file->data() + _stations[index].stationOffset,
+                       _stations[index].stationLength);
+  }
+
+  string_view TemperatureCache::name(const int index) const {
+    return string_view(_file->data() + _stations[index].nameOffset, _stations[index].nameLength);
+  }
+
+  // Index of a station by its STATION or NAME, -1 if there is none
+  int TemperatureCache::find(string_view stationOrName) const {
+    for (int i = 0; i < stationCount(); i++) {
+      if (station(i) == stationOrName || name(i) == stationOrName) return i;
+    }
+    return -1;
+  }
+
+  // A city whose columns point straight into the mapping
+  CityTemperatureData *TemperatureCache::readCity(string cityName, const int index) const {
+    const CacheStation &entry = _stations[index];
+    const char *columns = _file->data() + entry.columnsOffset;
+    CityColumns view = {reinterpret_cast<const int *>(columns),
+                        reinterpret_cast<const int *>(columns + entry.columnStride),
+                        reinterpret_cast<const int *>(columns + 2 * entry.columnStride),
+                        reinterpret_cast<const float *>(columns + 3 * entry.columnStride),
+                        reinterpret_cast<const float *>(columns + 4 * entry.columnStride),
+                        reinterpret_cast<const float *>(columns + 5 * entry.columnStride)};
+    return new CityTemperatureData(cityName, view, entry.numYears, _file);
+  }
+}  // namespace csi281
@@ -0,0 +1,102 @@
+//
+//  TemperatureCache.h
+//
+//  Binary columnar cache of CityTemperatureData. A CSV is converted once,
+//  after which the cache is memory mapped and its columns are served as they
+//  are, without parsing anything.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef TemperatureCache_hpp
+#define TemperatureCache_hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CityTemperatureData.h"
+#include "MappedFile.h"
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  // Layout of a cache file (all little endian, offsets from the file start):
+  //   CacheHeader
+  //   CacheStation[numStations]
+  //   the STATION and NAME strings, back to back
+  //   for each station its six columns in CityYear field order, each one
+  //   starting on a 64 byte boundary
+  struct CacheHeader {
+    char magic[8];                // "CSI281TC"
+    uint32_t byteOrder;           // 0x01020304 as written by the producer
+    uint32_t version;             // bumped whenever the layout changes
+    uint32_t numStations;         // entries in the station table
+    uint32_t reserved;            // zero
+    uint64_t stationTableOffset;  // where the CacheStation entries start
+    uint64_t fileSize;            // total size, to catch truncated files
+  };
+
+  struct CacheStation {
+    uint64_t stationOffset;  // STATION string
+    uint64_t nameOffset;     // NAME string
+    uint32_t stationLength;
+    uint32_t nameLength;
+    int32_t numYears;
+    int32_t firstYear;
+    uint64_t columnsOffset;  // first of the six columns
+    uint64_t columnStride;   // bytes from one column to the next
+  };
+
+  // Write cities to fileName in the cache format, storing stations[i] and
+  // each city's name as its STATION and NAME
+  void writeTemperatureCache(const string &fileName,
+                             const vector<const CityTemperatureData *> &cities,
+                             const vector<string> &stations);
+
+  // Convert every STATION block of a CSV into a cache file
+  void convertCsvToCache(const string &csvFileName, const string &cacheFileName);
+
+  // A mapped cache file. Throws runtime_error if it is missing or malformed.
+  class TemperatureCache {
+  public:
+    explicit TemperatureCache(const string &fileName);
+    int stationCount() const { return static_cast<int>(_header->numStations); }
+    string_view station(const int index) const;
+    string_view name(const int index) const;
+    // Index of a station by its STATION or NAME, -1 if there is none
+    int find(string_view stationOrName) const;
+    // A city whose columns point straight into the mapping; the mapping stays
+    // alive for as long as any city read from it
+    CityTemperatureData *readCity(string cityName, const int index) const;
+
+  private:
+    shared_ptr<const MappedFile> _file;
+    const CacheHeader *_header;
+    const CacheStation *_stations;
+  };
+}  // namespace csi281
+
+#endif /* TemperatureCache_hpp */
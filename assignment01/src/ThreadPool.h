@@ -0,0 +1,106 @@
+//
+//  ThreadPool.h
+//
+//  A small fixed-size pool of worker threads that run submitted tasks.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+
+  // Runs tasks on a fixed set of threads; the destructor finishes every
+  // task that was already submitted and then joins the threads
+  class ThreadPool {
+  public:
+    // numThreads of 0 means one thread per hardware thread
+    explicit ThreadPool(unsigned numThreads = 0) : _stopping(false) {
+      if (numThreads == 0) numThreads = max(1u, thread::hardware_concurrency());
+      for (unsigned i = 0; i < numThreads; i++) _workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() {
+      {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+      }
+      _wakeUp.notify_all();
+      for (thread &worker : _workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(_workers.size()); }
+
+    // Queue task and get a future for its result (or its exception)
+    template <typename F> future<invoke_result_t<F>> submit(F task) {
+      auto packaged = make_shared<packaged_task<invoke_result_t<F>()>>(std::move(task));
+      future<invoke_result_t<F>> result = packaged->get_future();
+      {
+        lock_guard<mutex> lock(_mutex);
+        _tasks.push([packaged] { (*packaged)(); });
+      }
+      _wakeUp.notify_one();
+      return result;
+    }
+
+  private:
+    void work() {
+      while (true) {
+        function<void()> task;
+        {
+          unique_lock<mutex> lock(_mutex);
+          _wakeUp.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+          if (_tasks.empty()) return;  // stopping and nothing left to do
+          task = std::move(_tasks.front());
+          _tasks.pop();
+        }
+        task();
+      }
+    }
+
+    vector<thread> _workers;
+    queue<function<void()>> _tasks;
+    mutex _mutex;
+    condition_variable _wakeUp;
+    bool _stopping;
+  };
+}  // namespace csi281
+
+#endif /* ThreadPool_hpp */
@@ -28,8 +28,15 @@
 #include "csv.h"
 
 #include <algorithm>  // for remove_if()
+#include <charconv>   // for from_chars()
+#include <cstring>    // for memchr()
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "CsvIndex.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
@@ -90,28 +97,361 @@ namespace csi281 {
   }
 
   // Read city by looking at the specified lines in the CSV
-  // You'll need to open an ifstream to fileName
-  // You'll need to read CityYears from the file using readLine() until there
-  // is nothing left to read
-  // The ifstream method good() may be useful
-  // Make sure to just read between startLine and endLine (inclusive of endLine)
-  // Construct a CityTemperatureData and return it
-  // create an array of CityYear instances to pass to the CityTemperatureData constructor
-  // when the CityTemperatureData is created, it will take ownership of the array
+  // The file is memory mapped and the lines are parsed in place, see the
+  // MappedFile overload below
   CityTemperatureData* readCity(string cityName, string fileName, int startLine, int endLine) {
-      ifstream readFile(fileName);
-      string temp;
-      int curline = 0;
-      // set the file on the correct line to read
-      while (getline(readFile, temp) && curline != startLine - 1) {
-        curline++;
+    MappedFile file(fileName);
+    return readCity(cityName, file, startLine, endLine);
+  }
+
+  static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+  // Strip spaces, tabs and line endings off both ends of a view
+  static string_view trim(string_view text) {
+    size_t first = 0;
+    size_t last = text.size();
+    while (first < last && isBlank(text[first])) first++;
+    while (last > first && isBlank(text[last - 1])) last--;
+    return text.substr(first, last - first);
+  }
+
+  // Strip whitespace and one pair of surrounding quotes off a cell, plus a
+  // leading '+' which from_chars() doesn't accept but stoi()/stof() do
+  static string_view numberText(string_view cell) {
+    cell = trim(cell);
+    if (cell.size() >= 2 && cell.front() == '"' && cell.back() == '"') {
+      cell = trim(cell.substr(1, cell.size() - 2));
+    }
+    if (cell.size() >= 2 && cell.front() == '+' && cell[1] != '-') cell.remove_prefix(1);
+    return cell;
+  }
+
+  // Turn a from_chars() result into a CellError
+  static CellError cellError(from_chars_result result, const char* last) {
+    if (result.ec == errc::result_out_of_range) return CellError::OutOfRange;
+    if (result.ec != errc() || result.ptr != last) return CellError::Malformed;
+    return CellError::None;
+  }
+
+  // Convert a cell into an int without allocating or throwing
+  CellError parseIntCell(string_view cell, int &value) {
+    cell = numberText(cell);
+    if (cell.empty()) return CellError::Empty;
+    const char* last = cell.data() + cell.size();
+    int parsed = 0;
+    CellError error = cellError(from_chars(cell.data(), last, parsed), last);
+    if (error == CellError::None) value = parsed;
+    return error;
+  }
+
+  // Convert a cell into a float without allocating or throwing
+  CellError parseFloatCell(string_view cell, float &value) {
+    cell = numberText(cell);
+    if (cell.empty()) return CellError::Empty;
+    const char* last = cell.data() + cell.size();
+    float parsed = 0;
+    CellError error = cellError(from_chars(cell.data(), last, parsed), last);
+    if (error == CellError::None) value = parsed;
+    return error;
+  }
+
+  // Throw for a cell that didn't convert, like stoi() and stof() do
+  static void throwCellError(CellError error) {
+    if (error == CellError::OutOfRange) throw out_of_range("number cell out of range");
+    if (error != CellError::None) throw invalid_argument("malformed number cell");
+  }
+
+  static int toInt(string_view cell) {
+    int value = 0;
+    throwCellError(parseIntCell(cell, value));
+    return value;
+  }
+
+  static float toFloat(string_view cell) {
+    float value = 0;
+    throwCellError(parseFloatCell(cell, value));
+    return value;
+  }
+
+  // Split the next cell off the front of *line* without copying anything.
+  // Surrounding quotes are stripped and commas inside quotes are kept;
+  // doubled quotes inside a quoted cell are left escaped.
+  string_view nextCell(string_view &line) {
+    line = line.substr(min(line.find_first_not_of(" \t"), line.size()));
+    string_view cell;
+    size_t comma;
+    if (!line.empty() && line.front() == '"') {
+      // find the closing quote, stepping over "" escapes
+      size_t close = 1;
+      while ((close = line.find('"', close)) != string_view::npos && close + 1 < line.size()
+             && line[close + 1] == '"') {
+        close += 2;
+      }
+      if (close == string_view::npos) {  // unterminated, take the rest
+        cell = line.substr(1);
+        line = string_view();
+        return cell;
+      }
+      cell = line.substr(1, close - 1);
+      comma = line.find(',', close + 1);
+    } else {
+      comma = line.find(',');
+      cell = trim(line.substr(0, comma));
+    }
+    line = comma == string_view::npos ? string_view() : line.substr(comma + 1);
+    return cell;
+  }
+
+  // Turn the cells after STATION and NAME into a CityYear
+  static CityYear parseYearCells(string_view line) {
+    CityYear newCityYear;
+    newCityYear.year = toInt(nextCell(line));
+    newCityYear.numDaysBelow32 = toInt(nextCell(line));
+    newCityYear.numDaysAbove90 = toInt(nextCell(line));
+    newCityYear.averageTemperature = toFloat(nextCell(line));
+    newCityYear.averageMax = toFloat(nextCell(line));
+    newCityYear.averageMin = toFloat(nextCell(line));
+    return newCityYear;
+  }
+
+  // Turn a single line of raw CSV bytes into a CityYear
+  CityYear parseLine(string_view line) {
+    nextCell(line);  // STATION
+    nextCell(line);  // NAME
+    return parseYearCells(line);
+  }
+
+  // Parse numYears consecutive lines starting at position into a new city
+  static CityTemperatureData* parseLines(string cityName, const char* position, const char* end,
+                                         int numYears) {
+    CityYear* dataArray = new CityYear[numYears];
+    try {
+      for (int i = 0; i < numYears; i++) {
+        if (position == end) throw out_of_range("CSV has fewer lines than requested");
+        const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+        const char* lineEnd = newline == nullptr ? end : newline;
+        dataArray[i] = parseLine(string_view(position, lineEnd - position));
+        position = newline == nullptr ? end : newline + 1;
+      }
+    } catch (...) {
+      delete[] dataArray;
+      throw;
+    }
+    return new CityTemperatureData(cityName, dataArray, numYears);
+  }
+
+  // Read city by parsing the specified lines straight out of a mapped CSV
+  // Lines are counted from 0 (the header), endLine is inclusive and
+  // out_of_range is thrown if the file is shorter than that
+  CityTemperatureData* readCity(string cityName, const MappedFile &file, int startLine,
+                                int endLine) {
+    const char* position = file.data();
+    const char* end = position + file.size();
+    // skip ahead to startLine
+    for (int line = 0; line < startLine; line++) {
+      const char* newline
+          = position == end ? nullptr
+                            : static_cast<const char*>(memchr(position, '\n', end - position));
+      if (newline == nullptr) throw out_of_range("CSV has fewer lines than requested");
+      position = newline + 1;
+    }
+    return parseLines(cityName, position, end, endLine - startLine + 1);
+  }
+
+  // Read city by seeking straight to the specified lines through an index
+  CityTemperatureData* readCity(string cityName, const CsvIndex &index, int startLine,
+                                int endLine) {
+    if (startLine < 0 || endLine < startLine || endLine >= index.lineCount()) {
+      throw out_of_range("CSV has fewer lines than requested");
+    }
+    const char* begin = index.file().data();
+    return parseLines(cityName, begin + index.lineOffset(startLine),
+                      begin + index.lineOffset(endLine + 1), endLine - startLine + 1);
+  }
+
+  CityTemperatureData* readCity(string cityName, const CsvIndex &index,
+                                const StationBlock &station) {
+    return readCity(cityName, index, station.startLine, station.endLine);
+  }
+
+  // Rows of one station that sit next to each other in the file
+  struct StationRun {
+    string_view station;
+    string_view name;
+    vector<CityYear> years;
+  };
+
+  // End of the record starting at position: the first newline that isn't
+  // inside quotes, or end
+  static const char* recordEnd(const char* position, const char* end) {
+    bool quoted = false;
+    while (true) {
+      const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+      const char* lineEnd = newline == nullptr ? end : newline;
+      quoted ^= count(position, lineEnd, '"') % 2 == 1;
+      if (!quoted || newline == nullptr) return lineEnd;
+      position = newline + 1;
+    }
+  }
+
+  // Start of the first record after position, given whether position is
+  // inside quotes
+  static const char* nextRecord(const char* position, const char* end, bool quoted) {
+    for (; position < end; position++) {
+      if (*position == '"') {
+        quoted = !quoted;
+      } else if (*position == '\n' && !quoted) {
+        return position + 1;
       }
-      CityYear *dataArray = new CityYear[endLine - startLine + 1];
-      for (int i = startLine; i <= endLine; i++) {
-          CityYear toAdd = readLine(readFile);
-          *(dataArray + (i - startLine)) = toAdd;
+    }
+    return end;
+  }
+
+  // Rows of one station gathered from anywhere in the file
+  struct StationRows {
+    string_view name;
+    vector<CityYear> years;
+  };
+
+  // Room reserved for the first station before there is anything to go by
+  static const size_t FIRST_STATION_YEARS = 64;
+
+  // Put a station's years in order and turn them into a city
+  static unique_ptr<CityTemperatureData> buildCity(StationRows &rows) {
+    auto byYear = [](const CityYear &a, const CityYear &b) { return a.year < b.year; };
+    if (!is_sorted(rows.years.begin(), rows.years.end(), byYear)) {
+      stable_sort(rows.years.begin(), rows.years.end(), byYear);
+    }
+    int numYears = static_cast<int>(rows.years.size());
+    CityYear* dataArray = new CityYear[numYears];
+    copy(rows.years.begin(), rows.years.end(), dataArray);
+    return make_unique<CityTemperatureData>(string(rows.name), dataArray, numYears);
+  }
+
+  // Parse every record in [position, stop) into runs of rows per station
+  static vector<StationRun> parseRuns(const char* position, const char* stop) {
+    vector<StationRun> runs;
+    while (position < stop) {
+      const char* end = recordEnd(position, stop);
+      string_view record(position, end - position);
+      position = end == stop ? stop : end + 1;
+      if (record.find_first_not_of(" \t\r") == string_view::npos) continue;
+      string_view station = nextCell(record);
+      string_view name = nextCell(record);
+      if (runs.empty() || runs.back().station != station) runs.push_back({station, name, {}});
+      runs.back().years.push_back(parseYearCells(record));
+    }
+    return runs;
+  }
+
+  // Read every station of a CSV by splitting it into byte ranges and parsing
+  // them on a thread pool. Each range is first counted for quotes, so every
+  // range knows whether it starts inside a quoted cell; then its boundaries
+  // are moved to the next record start and the records in between are parsed.
+  // Finally the runs are merged per station in file order and sorted by year.
+  CityMap readAllCitiesParallel(const string &fileName, unsigned numThreads,
+                                size_t minChunkBytes) {
+    MappedFile file(fileName);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const char* body = begin == end ? end : recordEnd(begin, end);  // skip the header
+    if (body != end) body++;
+
+    ThreadPool pool(numThreads);
+    size_t bodyBytes = end - body;
+    size_t numChunks = bodyBytes / max<size_t>(minChunkBytes, 1);
+    numChunks = max<size_t>(1, min<size_t>(numChunks, pool.size() * 4));
+    vector<const char*> bounds(numChunks + 1);
+    for (size_t i = 0; i <= numChunks; i++) bounds[i] = body + bodyBytes * i / numChunks;
+
+    // pass 1: quote parity of every chunk, which tells each one its quote state
+    vector<future<bool>> parities;
+    for (size_t i = 0; i < numChunks; i++) {
+      parities.push_back(pool.submit(
+          [&bounds, i] { return count(bounds[i], bounds[i + 1], '"') % 2 == 1; }));
+    }
+    vector<char> startsQuoted(numChunks + 1, false);
+    for (size_t i = 0; i < numChunks; i++) {
+      startsQuoted[i + 1] = startsQuoted[i] ^ parities[i].get();
+    }
+
+    // pass 2: line every chunk up with record boundaries and parse it
+    vector<future<vector<StationRun>>> parts;
+    for (size_t i = 0; i < numChunks; i++) {
+      parts.push_back(pool.submit([&, i] {
+        const char* start = i == 0 ? body : nextRecord(bounds[i], end, startsQuoted[i]);
+        const char* stop
+            = i + 1 == numChunks ? end : nextRecord(bounds[i + 1], end, startsQuoted[i + 1]);
+        return start < stop ? parseRuns(start, stop) : vector<StationRun>();
+      }));
+    }
+    // the tasks read the mapping, so let all of them finish before rethrowing
+    for (auto &part : parts) part.wait();
+
+    // merge the runs in file order
+    map<string_view, StationRows> stations;
+    for (auto &part : parts) {
+      for (StationRun &run : part.get()) {
+        StationRows &rows = stations[run.station];
+        if (rows.years.empty()) {
+          rows.name = run.name;
+          rows.years = std::move(run.years);
+        } else {
+          rows.years.insert(rows.years.end(), run.years.begin(), run.years.end());
+        }
       }
-      CityTemperatureData* newCity = new CityTemperatureData(cityName, dataArray, endLine - startLine + 1);
-      return newCity;
+    }
+
+    // put every station's years in order and build the cities
+    vector<future<unique_ptr<CityTemperatureData>>> built;
+    for (auto &[station, rows] : stations) {
+      built.push_back(pool.submit([&rows] { return buildCity(rows); }));
+    }
+    for (auto &city : built) city.wait();
+    CityMap cities;
+    size_t next = 0;
+    for (auto &[station, rows] : stations) cities[string(station)] = built[next++].get();
+    return cities;
+  }
+
+  // Read every station of a CSV in one streaming pass, grouping the rows by
+  // their STATION cell. Stations usually come in blocks, so the last station
+  // seen is checked before the map. A new station's rows are reserved up
+  // front for as many years as the stations before it had on average.
+  CityMap readAllCities(const string &fileName) {
+    MappedFile file(fileName);
+    const char* position = file.data();
+    const char* end = position + file.size();
+    if (position != end) position = recordEnd(position, end);  // skip the header
+
+    map<string_view, StationRows> stations;
+    string_view currentStation;
+    StationRows* current = nullptr;
+    size_t numRows = 0;
+    while (position < end) {
+      position++;  // past the newline ending the previous record
+      const char* stop = recordEnd(position, end);
+      string_view record(position, stop - position);
+      position = stop;
+      if (record.find_first_not_of(" \t\r") == string_view::npos) continue;
+      string_view station = nextCell(record);
+      string_view name = nextCell(record);
+      if (current == nullptr || station != currentStation) {
+        auto [entry, added] = stations.try_emplace(station);
+        current = &entry->second;
+        currentStation = station;
+        if (added) {
+          current->name = name;
+          size_t previous = stations.size() - 1;
+          current->years.reserve(previous == 0 ? FIRST_STATION_YEARS : numRows / previous);
+        }
+      }
+      current->years.push_back(parseYearCells(record));
+      numRows++;
+    }
+
+    CityMap cities;
+    for (auto &[station, rows] : stations) cities[string(station)] = buildCity(rows);
+    return cities;
   }
 }  // namespace csi281
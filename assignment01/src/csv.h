@@ -30,15 +30,22 @@
 #define csv_hpp
 
 #include <fstream>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include "CityTemperatureData.h"
+#include "MappedFile.h"
 #include "MemoryLeakDetector.h"
 
 using namespace std;
 
 namespace csi281 {
 
+  class CsvIndex;
+  struct StationBlock;
+
   // Remove extraneous characters from string so it can
   // be converted into a number
   void clean(string &str);
@@ -54,6 +61,46 @@ namespace csi281 {
 
   // Read city by looking at the specified lines in the CSV
   CityTemperatureData* readCity(string cityName, string fileName, int startLine, int endLine);
+
+  // Why a cell couldn't be turned into a number
+  enum class CellError { None, Empty, Malformed, OutOfRange };
+
+  // Convert a cell into a number without allocating or throwing. Whitespace
+  // and surrounding quotes are skipped in place, then the rest has to be
+  // exactly one number; value is only written when None is returned.
+  CellError parseIntCell(string_view cell, int &value);
+  CellError parseFloatCell(string_view cell, float &value);
+
+  // Split the next cell off the front of *line* without copying anything.
+  // Surrounding quotes are stripped and commas inside quotes are kept;
+  // doubled quotes inside a quoted cell are left escaped.
+  string_view nextCell(string_view &line);
+
+  // Turn a single line of raw CSV bytes into a CityYear
+  CityYear parseLine(string_view line);
+
+  // Read city by parsing the specified lines straight out of a mapped CSV
+  CityTemperatureData* readCity(string cityName, const MappedFile &file, int startLine,
+                                int endLine);
+
+  // Read city by seeking straight to the specified lines through an index
+  CityTemperatureData* readCity(string cityName, const CsvIndex &index, int startLine,
+                                int endLine);
+  CityTemperatureData* readCity(string cityName, const CsvIndex &index,
+                                const StationBlock &station);
+
+  // Every station of a CSV keyed by its STATION cell; each city is named
+  // after its NAME cell and holds its years in order
+  using CityMap = map<string, unique_ptr<CityTemperatureData>>;
+
+  // Read every station of a CSV in one streaming pass
+  CityMap readAllCities(const string &fileName);
+
+  // Read every station of a CSV by splitting it into byte ranges of at least
+  // minChunkBytes and parsing them on numThreads threads (0 means one per
+  // hardware thread)
+  CityMap readAllCitiesParallel(const string &fileName, unsigned numThreads = 0,
+                                size_t minChunkBytes = 1 << 20);
 }  // namespace csi281
 
 #endif /* csv_hpp */
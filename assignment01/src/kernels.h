@@ -0,0 +1,50 @@
+//
+//  kernels.h
+//
+//  Vectorized aggregate kernels over the contiguous columns of
+//  CityTemperatureData. Uses AVX2 or SSE2 when the compiler targets them,
+//  and plain loops everywhere else.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef kernels_hpp
+#define kernels_hpp
+
+#include "MemoryLeakDetector.h"
+
+namespace csi281 {
+
+  // Sum of a column; floats are accumulated in doubles so long columns
+  // don't lose precision
+  double sumColumn(const float *values, const int count);
+  int sumColumn(const int *values, const int count);
+
+  // Smallest and largest value of a column; an empty column gives back the
+  // identity of the operation (infinity for min, -infinity for max, and the
+  // int limits for ints)
+  float minColumn(const float *values, const int count);
+  float maxColumn(const float *values, const int count);
+  int minColumn(const int *values, const int count);
+  int maxColumn(const int *values, const int count);
+}  // namespace csi281
+
+#endif /* kernels_hpp */
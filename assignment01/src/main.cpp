@@ -31,6 +31,8 @@
 #include <iostream>
 
 #include "PPlot.h"
+#include "CsvIndex.h"
+#include "RollingWindow.h"
 #include "SVGPainter.h"
 #include "csv.h"
 
@@ -127,6 +129,9 @@ static void drawExtremeDaysChart(CityTemperatureData &city1, CityTemperatureData
   painter.writeFile("ExtremeDaysChart.svg");
 }
 
+// Window of the moving average drawn over the average temperatures
+static const int TREND_YEARS = 10;
+
 // Draw a chart showing the average temperatures
 // for each city in "AvgTempChart.svg"
 static void drawAvgTempChart(CityTemperatureData &city1, CityTemperatureData &city2) {
@@ -164,6 +169,29 @@ static void drawAvgTempChart(CityTemperatureData &city1, CityTemperatureData &ci
 
   pplot.mPlotDataContainer.AddXYPlot(theX2, theY2, legend2, theDataDrawer2);
 
+  // 10 year moving averages, each plotted at the last year of its window
+  CityTemperatureData *cities[] = {&city1, &city2};
+  PColor trendColors[] = {PColor(50, 0, 100), PColor(0, 120, 120)};
+  for (int c = 0; c < 2; c++) {
+    RollingSeries trend
+        = rollingWindows(*cities[c], CityColumn::AverageTemperature, {TREND_YEARS})[0];
+    PlotData *theX = new PlotData();
+    PlotData *theY = new PlotData();
+    for (size_t i = 0; i < trend.mean.size(); i++) {
+      theX->push_back(cities[c]->getFirstYear() + i + TREND_YEARS - 1);
+      theY->push_back(trend.mean[i]);
+    }
+    LineDataDrawer *theDataDrawer = new LineDataDrawer();
+    theDataDrawer->mDrawPoint = false;
+    theDataDrawer->mDrawLine = true;
+
+    LegendData *legend = new LegendData();
+    legend->mName = cities[c]->getName() + " " + to_string(TREND_YEARS) + " Year Average";
+    legend->mColor = trendColors[c];
+
+    pplot.mPlotDataContainer.AddXYPlot(theX, theY, legend, theDataDrawer);
+  }
+
   pplot.mMargins.mLeft = 100;
   pplot.mMargins.mTop = 50;
   pplot.mMargins.mRight = 50;
@@ -188,9 +216,21 @@ int main(int argc, char *argv[]) {
   // run tests
   // int result = Catch::Session().run( argc, argv );
 
+  // index the file once, then seek straight to each city's block
+  CsvIndex index("tempdata.csv");
+  if (!index.wasLoaded()) index.save();
+
+  const StationBlock* nycBlock = index.findStation("USW00094728");
+  const StationBlock* burlingtonBlock = index.findStation("USW00014742");
+  if (nycBlock == nullptr || burlingtonBlock == nullptr) {
+    cerr << "tempdata.csv is missing the " << (nycBlock == nullptr ? "NYC" : "Burlington")
+         << " station" << endl;
+    return 1;
+  }
+
   // draw graphs
-  CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
-  CityTemperatureData* burlington = readCity("Burlington", "tempdata.csv", 52, 102);
+  CityTemperatureData* nyc = readCity("NYC", index, *nycBlock);
+  CityTemperatureData* burlington = readCity("Burlington", index, *burlingtonBlock);
   drawAvgTempChart(*nyc, *burlington);
   drawExtremeDaysChart(*nyc, *burlington);
   delete nyc;
@@ -32,8 +32,27 @@
 #define TEST_CASE(name, tags) DOCTEST_TEST_CASE(tags " " name)
 using doctest::Approx;
 
+#include <cstdio>  // for remove()
+#include <fstream>
+#include <iterator>  // for istreambuf_iterator
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#  include <unistd.h>  // for pipe()
+#endif
+
 #include "CityTemperatureData.h"
+#include "CsvIndex.h"
+#include "CsvSchema.h"
+#include "CsvStream.h"
+#include "QueryEngine.h"
+#include "RollingWindow.h"
+#include "SyntheticData.h"
+#include "TemperatureCache.h"
 #include "csv.h"
+#include "kernels.h"
 
 using namespace std;
 using namespace csi281;
@@ -83,3 +102,823 @@ TEST_CASE("Burlington Test Data", "[Burlington]") {
 
   delete burlington;
 }
+
+TEST_CASE("Zero-Copy Cell Parsing", "[Parsing]") {
+  SECTION("Quoted and unquoted cells") {
+    string_view line = "\"USW1\", \"A, B\",1968 ,\"say \"\"hi\"\"\"";
+    CHECK(nextCell(line) == "USW1");
+    CHECK(nextCell(line) == "A, B");
+    CHECK(nextCell(line) == "1968");
+    CHECK(nextCell(line) == "say \"\"hi\"\"");
+    CHECK(line.empty());
+  }
+
+  SECTION("Whole line into a CityYear") {
+    CityYear year = parseLine(
+        "\"USW00094728\",\"NY CITY CENTRAL PARK\",\"1970\",\"29\",\"22\",\"54.2\",\"61.7\",\"46.8\"\r");
+    CHECK(year.year == 1970);
+    CHECK(year.numDaysBelow32 == 29);
+    CHECK(year.numDaysAbove90 == 22);
+    CHECK(year.averageTemperature == 54.2f);
+    CHECK(year.averageMax == 61.7f);
+    CHECK(year.averageMin == 46.8f);
+  }
+
+  SECTION("Malformed numbers throw") {
+    CHECK_THROWS_AS(parseLine("\"A\",\"B\",\"19x0\",\"1\",\"1\",\"1\",\"1\",\"1\""),
+                    invalid_argument);
+  }
+
+  SECTION("Reading from a mapped file") {
+    MappedFile file("tempdata.csv");
+    CityTemperatureData* burlington = readCity("Burlington", file, 52, 102);
+    CHECK(burlington->count() == 51);
+    CHECK((*burlington)[1978].numDaysBelow32 == 87);
+    CHECK((*burlington)[2018].averageMax == 56.9f);
+    CHECK_THROWS_AS(readCity("Nowhere", file, 100, 200), out_of_range);
+    delete burlington;
+  }
+}
+
+TEST_CASE("CSV Index", "[Index]") {
+  CsvIndex index("tempdata.csv", false);
+
+  REQUIRE(index.lineCount() == 103);
+  REQUIRE(index.stations().size() == 2);
+
+  SECTION("Line offsets") {
+    CHECK(index.lineOffset(0) == 0);
+    CHECK(index.line(0).substr(0, 9) == "\"STATION\"");
+    CHECK(parseLine(index.line(3)).year == 1970);
+  }
+
+  SECTION("Station blocks") {
+    const StationBlock* nycBlock = index.findStation("USW00094728");
+    REQUIRE(nycBlock != nullptr);
+    CHECK(nycBlock->name == "NY CITY CENTRAL PARK");
+    CHECK(nycBlock->startLine == 1);
+    CHECK(nycBlock->endLine == 51);
+    const StationBlock* burlingtonBlock = index.findStation("BURLINGTON INTERNATIONAL AIRPORT");
+    REQUIRE(burlingtonBlock != nullptr);
+    CHECK(burlingtonBlock->startLine == 52);
+    CHECK(burlingtonBlock->endLine == 102);
+    CHECK(index.findStation("NOWHERE") == nullptr);
+  }
+
+  SECTION("Reading through the index") {
+    CityTemperatureData* burlington
+        = readCity("Burlington", index, *index.findStation("USW00014742"));
+    CHECK(burlington->count() == 51);
+    CHECK(burlington->getTotalDaysBelow32() == 3242);
+    CHECK((*burlington)[1989].averageTemperature == 44.6f);
+    CHECK_THROWS_AS(readCity("Nowhere", index, 100, 200), out_of_range);
+    delete burlington;
+  }
+
+  SECTION("Saving and loading") {
+    index.save();
+    CsvIndex loaded("tempdata.csv");
+    CHECK(loaded.wasLoaded());
+    CHECK(loaded.lineCount() == index.lineCount());
+    CHECK(loaded.lineOffset(52) == index.lineOffset(52));
+    REQUIRE(loaded.stations().size() == 2);
+    CHECK(loaded.stations()[1].name == "BURLINGTON INTERNATIONAL AIRPORT");
+    CHECK(loaded.findStation("USW00014742") == &loaded.stations()[1]);
+    CHECK(loaded.findStation("NY CITY CENTRAL PARK") == &loaded.stations()[0]);
+    remove(index.indexFileName().c_str());
+  }
+
+  SECTION("Every station of a big file is found by its STATION and NAME cells") {
+    const string fileName = "index_stations_test.csv";
+    SyntheticOptions options;
+    options.stations = 5000;
+    options.yearsPerStation = 2;
+    writeSyntheticData(fileName, options);
+    CsvIndex many(fileName, false);
+    REQUIRE(many.stations().size() == 5000);
+    for (const StationBlock& block : many.stations()) {
+      CHECK(many.findStation(block.station) == &block);
+      CHECK(many.findStation(block.name)->name == block.name);
+    }
+    CHECK(many.findStation("NOWHERE") == nullptr);
+    remove(fileName.c_str());
+  }
+
+  SECTION("An edit in the middle that keeps the size makes the saved index stale") {
+    ifstream original("tempdata.csv", ios::binary);
+    string text((istreambuf_iterator<char>(original)), istreambuf_iterator<char>());
+    const string fileName = "index_edit_test.csv";
+    ofstream(fileName, ios::binary) << text;
+    CsvIndex(fileName, false).save();
+    // change a digit halfway through, away from both ends of the file
+    size_t digit = text.find_first_of("0123456789", text.size() / 2);
+    text[digit] = text[digit] == '1' ? '2' : '1';
+    ofstream(fileName, ios::binary) << text;
+    CsvIndex edited(fileName);
+    CHECK_FALSE(edited.wasLoaded());
+    CHECK(edited.lineCount() == 103);
+    remove(edited.indexFileName().c_str());
+    remove(fileName.c_str());
+  }
+}
+
+TEST_CASE("Column Kernels", "[Kernels]") {
+  // odd lengths so both the vector body and the scalar tail get exercised
+  for (int length : {0, 1, 7, 8, 9, 33, 1001}) {
+    float* floats = new float[length];
+    int* ints = new int[length];
+    double floatSum = 0;
+    int intSum = 0;
+    float floatMin = 1e30f, floatMax = -1e30f;
+    int intMin = 1 << 30, intMax = -(1 << 30);
+    for (int i = 0; i < length; i++) {
+      floats[i] = static_cast<float>((i * 37) % 101) - 50.5f;
+      ints[i] = (i * 7919) % 211 - 100;
+      floatSum += floats[i];
+      intSum += ints[i];
+      floatMin = min(floatMin, floats[i]);
+      floatMax = max(floatMax, floats[i]);
+      intMin = min(intMin, ints[i]);
+      intMax = max(intMax, ints[i]);
+    }
+    CHECK(sumColumn(floats, length) == Approx(floatSum));
+    CHECK(sumColumn(ints, length) == intSum);
+    if (length > 0) {
+      CHECK(minColumn(floats, length) == floatMin);
+      CHECK(maxColumn(floats, length) == floatMax);
+      CHECK(minColumn(ints, length) == intMin);
+      CHECK(maxColumn(ints, length) == intMax);
+    } else {
+      CHECK(minColumn(floats, 0) == numeric_limits<float>::infinity());
+      CHECK(maxColumn(floats, 0) == -numeric_limits<float>::infinity());
+      CHECK(minColumn(ints, 0) == numeric_limits<int>::max());
+      CHECK(maxColumn(ints, 0) == numeric_limits<int>::min());
+    }
+    delete[] floats;
+    delete[] ints;
+  }
+
+  SECTION("Aggregates over the columns") {
+    CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
+    CHECK(nyc->years()[0] == 1968);
+    CHECK(nyc->averageTemperatures()[2] == 54.2f);
+    CHECK(nyc->getAllTimeMax() >= (*nyc)[2018].averageMax);
+    delete nyc;
+  }
+
+  SECTION("Aggregates match a plain loop over the years") {
+    // first years of NYC, around and between the vector widths
+    for (int length : {1, 2, 7, 8, 9, 16, 17, 51}) {
+      CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, length);
+      REQUIRE(nyc->count() == length);
+      int below32 = 0, above90 = 0;
+      double temperatureSum = 0;
+      float highest = (*nyc)[1968].averageMax, lowest = (*nyc)[1968].averageMin;
+      for (int year = 1968; year < 1968 + length; year++) {
+        CityYear cityYear = (*nyc)[year];
+        below32 += cityYear.numDaysBelow32;
+        above90 += cityYear.numDaysAbove90;
+        temperatureSum += cityYear.averageTemperature;
+        if (cityYear.averageMax > highest) highest = cityYear.averageMax;
+        if (cityYear.averageMin < lowest) lowest = cityYear.averageMin;
+      }
+      CHECK(nyc->getTotalDaysBelow32() == below32);
+      CHECK(nyc->getTotalDaysAbove90() == above90);
+      CHECK(nyc->getAllTimeAverage() == Approx(temperatureSum / length));
+      CHECK(nyc->getAllTimeMax() == highest);
+      CHECK(nyc->getAllTimeMin() == lowest);
+      delete nyc;
+    }
+    CityTemperatureData empty("Empty");
+    CHECK(empty.getTotalDaysBelow32() == 0);
+    CHECK(empty.getTotalDaysAbove90() == 0);
+  }
+}
+
+TEST_CASE("Binary Temperature Cache", "[Cache]") {
+  convertCsvToCache("tempdata.csv", "tempdata.cache");
+  CityTemperatureData* burlington;
+  {
+    TemperatureCache cache("tempdata.cache");
+    REQUIRE(cache.stationCount() == 2);
+    CHECK(cache.station(0) == "USW00094728");
+    CHECK(cache.name(1) == "BURLINGTON INTERNATIONAL AIRPORT");
+    CHECK(cache.find("USW00014742") == 1);
+    CHECK(cache.find("NOWHERE") == -1);
+
+    CityTemperatureData* nyc = cache.readCity("NYC", cache.find("NY CITY CENTRAL PARK"));
+    REQUIRE(nyc->count() == 51);
+    CHECK(nyc->getFirstYear() == 1968);
+    CHECK((*nyc)[1970].numDaysBelow32 == 29);
+    CHECK((*nyc)[2011].averageTemperature == 56.4f);
+    CHECK(nyc->getAllTimeAverage() == Approx(55.25294118f).epsilon(0.01));
+    CHECK(nyc->getTotalDaysAbove90() == 891);
+    delete nyc;
+
+    burlington = cache.readCity("Burlington", 1);
+  }
+
+  SECTION("Cities keep the mapping alive") {
+    CHECK(burlington->getName() == "Burlington");
+    CHECK((*burlington)[2018].averageMax == 56.9f);
+    CHECK(burlington->getTotalDaysBelow32() == 3242);
+  }
+  delete burlington;
+
+  SECTION("Files that aren't caches are rejected") {
+    CHECK_THROWS_AS(TemperatureCache("tempdata.csv"), runtime_error);
+    CHECK_THROWS_AS(TemperatureCache("missing.cache"), runtime_error);
+  }
+  remove("tempdata.cache");
+}
+
+TEST_CASE("Parallel Ingestion", "[Parallel]") {
+  SECTION("Same data as readCity()") {
+    CityMap cities = readAllCitiesParallel("tempdata.csv", 4, 64);
+    REQUIRE(cities.size() == 2);
+    CityTemperatureData& nyc = *cities.at("USW00094728");
+    CHECK(nyc.getName() == "NY CITY CENTRAL PARK");
+    CHECK(nyc.count() == 51);
+    CHECK(nyc.getFirstYear() == 1968);
+    CHECK(nyc.getTotalDaysBelow32() == 967);
+    CHECK(nyc[2011].averageTemperature == 56.4f);
+    CityTemperatureData& burlington = *cities.at("USW00014742");
+    CHECK(burlington.count() == 51);
+    CHECK(burlington.getTotalDaysAbove90() == 357);
+  }
+
+  SECTION("Quoted newlines, interleaved stations and years out of order") {
+    {
+      ofstream out("parallel.csv");
+      out << "\"STATION\",\"NAME\",\"DATE\",\"DX32\",\"DX90\",\"TAVG\",\"TMAX\",\"TMIN\"\n";
+      for (int year = 2000; year < 2060; year++) {
+        int y = year % 2 == 0 ? year : 4060 - year;  // odd years backwards
+        out << "\"A\",\"PLAIN NAME\",\"" << y << "\",\"1\",\"2\",\"50.0\",\"60.0\",\"40.0\"\n";
+        out << "\"B\",\"TWO\nLINES, \"\"QUOTED\"\"\",\"" << year
+            << "\",\"3\",\"4\",\"40.0\",\"50.0\",\"30.0\"\r\n";
+      }
+    }
+    for (unsigned threads : {1u, 3u, 8u}) {
+      for (size_t chunk : {size_t(1), size_t(13), size_t(1) << 20}) {
+        CityMap cities = readAllCitiesParallel("parallel.csv", threads, chunk);
+        REQUIRE(cities.size() == 2);
+        CityTemperatureData& a = *cities.at("A");
+        CityTemperatureData& b = *cities.at("B");
+        CHECK(a.count() == 60);
+        CHECK(b.count() == 60);
+        CHECK(b.getName() == "TWO\nLINES, \"\"QUOTED\"\"");
+        bool inOrder = true;
+        for (int i = 0; i < 60; i++) {
+          inOrder = inOrder && a.years()[i] == 2000 + i && b.years()[i] == 2000 + i;
+        }
+        CHECK(inOrder);
+        CHECK(a.getTotalDaysBelow32() == 60);
+        CHECK(b.getTotalDaysAbove90() == 240);
+      }
+    }
+    remove("parallel.csv");
+  }
+}
+
+TEST_CASE("Allocation-Free Number Cells", "[Cells]") {
+  int i = -1;
+  float f = -1;
+
+  SECTION("Well formed cells") {
+    CHECK(parseIntCell("\"1968\"", i) == CellError::None);
+    CHECK(i == 1968);
+    CHECK(parseIntCell("  -12\t", i) == CellError::None);
+    CHECK(i == -12);
+    CHECK(parseIntCell("\" +7 \"", i) == CellError::None);
+    CHECK(i == 7);
+    CHECK(parseFloatCell("\"54.2\"", f) == CellError::None);
+    CHECK(f == 54.2f);
+    CHECK(parseFloatCell("-3.5e1\r\n", f) == CellError::None);
+    CHECK(f == -35.0f);
+  }
+
+  SECTION("Malformed cells leave the value alone") {
+    i = 5;
+    CHECK(parseIntCell("\"\"", i) == CellError::Empty);
+    CHECK(parseIntCell("   ", i) == CellError::Empty);
+    CHECK(parseIntCell("\"12a\"", i) == CellError::Malformed);
+    CHECK(parseIntCell("4.5", i) == CellError::Malformed);
+    CHECK(parseIntCell("99999999999", i) == CellError::OutOfRange);
+    CHECK(i == 5);
+    CHECK(parseFloatCell("abc", f) == CellError::Malformed);
+    CHECK(parseFloatCell("1e99", f) == CellError::OutOfRange);
+  }
+
+  SECTION("Same results as the stream based cells") {
+    istringstream iss("\"12\",\"54.8\"");
+    CHECK(parseIntCell("\"12\"", i) == CellError::None);
+    CHECK(readIntCell(iss) == i);
+    CHECK(parseFloatCell("\"54.8\"", f) == CellError::None);
+    CHECK(readFloatCell(iss) == f);
+  }
+}
+
+TEST_CASE("Station Discovery", "[Discovery]") {
+  SECTION("Every station of tempdata.csv") {
+    CityMap cities = readAllCities("tempdata.csv");
+    REQUIRE(cities.size() == 2);
+    CityTemperatureData& nyc = *cities.at("USW00094728");
+    CHECK(nyc.getName() == "NY CITY CENTRAL PARK");
+    CHECK(nyc.count() == 51);
+    CHECK(nyc[1970].numDaysBelow32 == 29);
+    CHECK(nyc.getTotalDaysAbove90() == 891);
+    CityTemperatureData& burlington = *cities.at("USW00014742");
+    CHECK(burlington.count() == 51);
+    CHECK(burlington[1978].numDaysBelow32 == 87);
+    CHECK(burlington.getAllTimeAverage() == Approx(45.70589f).epsilon(0.01));
+  }
+
+  SECTION("Interleaved stations match the parallel reader") {
+    {
+      ofstream out("discovery.csv");
+      out << "\"STATION\",\"NAME\",\"DATE\",\"DX32\",\"DX90\",\"TAVG\",\"TMAX\",\"TMIN\"\n";
+      for (int year = 1990; year < 2020; year++) {
+        for (int station = 0; station < 5; station++) {
+          out << "\"S" << station << "\",\"STATION " << station << "\",\"" << year << "\",\""
+              << station << "\",\"1\",\"" << year % 7 << ".5\",\"60.0\",\"40.0\"\n";
+        }
+      }
+      out << "\n";  // a trailing blank line is skipped
+    }
+    CityMap sequential = readAllCities("discovery.csv");
+    CityMap parallel = readAllCitiesParallel("discovery.csv", 4, 100);
+    REQUIRE(sequential.size() == 5);
+    REQUIRE(parallel.size() == 5);
+    for (auto& [station, city] : sequential) {
+      CHECK(city->count() == 30);
+      CHECK(city->getFirstYear() == 1990);
+      CHECK(city->getName() == parallel.at(station)->getName());
+      CHECK(city->getTotalDaysBelow32() == parallel.at(station)->getTotalDaysBelow32());
+      CHECK(city->getAllTimeAverage() == parallel.at(station)->getAllTimeAverage());
+    }
+    CHECK(sequential.at("S3")->getTotalDaysBelow32() == 90);
+    remove("discovery.csv");
+  }
+}
+
+TEST_CASE("Year Range Queries", "[Range]") {
+  CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
+
+  // reference answers by walking the years one at a time
+  auto expectedAverage = [nyc](int from, int to) {
+    double total = 0;
+    for (int year = from; year <= to; year++) total += (*nyc)[year].averageTemperature;
+    return total / (to - from + 1);
+  };
+  auto expectedBelow32 = [nyc](int from, int to) {
+    int total = 0;
+    for (int year = from; year <= to; year++) total += (*nyc)[year].numDaysBelow32;
+    return total;
+  };
+
+  for (bool indexed : {false, true}) {
+    if (indexed) nyc->buildRangeIndex();
+    CHECK(nyc->hasRangeIndex() == indexed);
+
+    SECTION("Ranges inside the data") {
+      CHECK(nyc->getAverage(1980, 2000) == Approx(expectedAverage(1980, 2000)));
+      CHECK(nyc->getTotalDaysBelow32(2004, 2018) == expectedBelow32(2004, 2018));
+      CHECK(nyc->getTotalDaysAbove90(1970, 1970) == 22);
+      CHECK(nyc->getAverageMax(2018, 2018) == 62.6f);
+      CHECK(nyc->getAverageMin(2000, 2000) == 46.9f);
+    }
+
+    SECTION("Whole range matches the all time aggregates") {
+      CHECK(nyc->getAverage(1968, 2018) == Approx(nyc->getAllTimeAverage()));
+      CHECK(nyc->getTotalDaysBelow32(1968, 2018) == 967);
+      CHECK(nyc->getTotalDaysAbove90(1968, 2018) == 891);
+    }
+
+    SECTION("Ranges are clipped to the data") {
+      CHECK(nyc->getTotalDaysAbove90(1900, 3000) == 891);
+      CHECK(nyc->getAverage(2010, 2100) == Approx(expectedAverage(2010, 2018)));
+      CHECK(nyc->getTotalDaysBelow32(1800, 1900) == 0);
+      CHECK(nyc->getAverage(2000, 1990) != nyc->getAverage(2000, 1990));  // NaN
+    }
+
+    SECTION("Ranges after the data or backwards are empty") {
+      CHECK(nyc->getTotalDaysBelow32(2100, 2200) == 0);
+      CHECK(nyc->getTotalDaysAbove90(2019, 2019) == 0);
+      CHECK(nyc->getAverageMax(2100, 2200) != nyc->getAverageMax(2100, 2200));  // NaN
+      CHECK(nyc->getTotalDaysBelow32(2000, 1990) == 0);
+      CHECK(nyc->getTotalDaysAbove90(2018, 1968) == 0);
+      CHECK(nyc->getTotalDaysBelow32(2200, 1800) == 0);
+      CHECK(nyc->getAverageMin(1800, 1700) != nyc->getAverageMin(1800, 1700));  // NaN
+    }
+
+    SECTION("Open ended ranges don't overflow") {
+      const int lowest = numeric_limits<int>::min(), highest = numeric_limits<int>::max();
+      CHECK(nyc->getTotalDaysAbove90(lowest, highest) == 891);
+      CHECK(nyc->getTotalDaysBelow32(2004, highest) == expectedBelow32(2004, 2018));
+      CHECK(nyc->getAverage(lowest, 2000) == Approx(expectedAverage(1968, 2000)));
+      CHECK(nyc->getTotalDaysBelow32(highest, lowest) == 0);
+    }
+  }
+
+  delete nyc;
+}
+
+TEST_CASE("Appending Years", "[Append]") {
+  CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
+
+  SECTION("Appending through several growths matches the whole city") {
+    CityTemperatureData grown("NYC");
+    for (int year = 1968; year <= 2018; year++) {
+      grown.append((*nyc)[year]);
+      CHECK(grown.count() == year - 1967);
+      CHECK(grown.getFirstYear() == 1968);
+    }
+    CHECK(grown.getAllTimeAverage() == Approx(nyc->getAllTimeAverage()));
+    CHECK(grown.getTotalDaysBelow32() == 967);
+    CHECK(grown.getTotalDaysAbove90() == 891);
+    CHECK(grown.getAllTimeMax() == nyc->getAllTimeMax());
+    CHECK(grown.getAllTimeMin() == nyc->getAllTimeMin());
+    CHECK(grown[2011].averageTemperature == 56.4f);
+  }
+
+  SECTION("Aggregates follow every append") {
+    CityTemperatureData* partial = readCity("NYC", "tempdata.csv", 1, 40);
+    partial->buildRangeIndex();
+    CityYear warm = {2008, 10, 120, 70.0f, 110.0f, 30.0f};
+    partial->append(warm);
+    CHECK(partial->getTotalDaysAbove90() == nyc->getTotalDaysAbove90(1968, 2007) + 120);
+    CHECK(partial->getAllTimeMax() == 110.0f);
+    CHECK(partial->getAllTimeMin() == 30.0f);
+    CHECK(partial->getAverage(2008, 2008) == 70.0f);
+    CHECK(partial->getTotalDaysBelow32(1968, 2008) == nyc->getTotalDaysBelow32(1968, 2007) + 10);
+    delete partial;
+  }
+
+  SECTION("Borrowed columns are copied before appending") {
+    convertCsvToCache("tempdata.csv", "tempdata.cache");
+    CityTemperatureData* cached;
+    {
+      TemperatureCache cache("tempdata.cache");
+      cached = cache.readCity("NYC", 0);
+    }
+    // more years than the borrowed columns' padding leaves room for, each a
+    // copy of the one 51 years before it
+    for (int year = 2019; year <= 2068; year++) {
+      CityYear next = (*nyc)[year - 51];
+      next.year = year;
+      cached->append(next);
+    }
+    REQUIRE(cached->count() == 101);
+    for (int year = 1968; year <= 2068; year++) {
+      CityYear actual = (*cached)[year];
+      CityYear expected = (*nyc)[year > 2018 ? year - 51 : year];
+      CHECK(actual.year == year);
+      CHECK(actual.numDaysBelow32 == expected.numDaysBelow32);
+      CHECK(actual.numDaysAbove90 == expected.numDaysAbove90);
+      CHECK(actual.averageTemperature == expected.averageTemperature);
+      CHECK(actual.averageMax == expected.averageMax);
+      CHECK(actual.averageMin == expected.averageMin);
+    }
+    CHECK((*cached)[1970].numDaysBelow32 == 29);
+    CHECK(cached->getTotalDaysAbove90() == 2 * 891 - (*nyc)[2018].numDaysAbove90);
+    delete cached;
+    remove("tempdata.cache");
+  }
+
+  SECTION("Years have to follow on from the last one") {
+    CityYear gap = (*nyc)[2018];
+    gap.year = 2020;
+    CHECK_THROWS_AS(nyc->append(gap), invalid_argument);
+    CHECK_THROWS_AS(nyc->append((*nyc)[2018]), invalid_argument);
+    CHECK(nyc->count() == 51);
+  }
+
+  delete nyc;
+}
+
+TEST_CASE("Rolling Windows", "[Rolling]") {
+  CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
+  vector<int> windows = {1, 5, 10, 30, 51, 60};
+
+  SECTION("Every window matches a brute force scan") {
+    vector<RollingSeries> series = rollingWindows(*nyc, CityColumn::AverageMax, windows);
+    REQUIRE(series.size() == windows.size());
+    for (const RollingSeries& s : series) {
+      int length = max(nyc->count() - s.window + 1, 0);
+      REQUIRE(s.mean.size() == static_cast<size_t>(length));
+      REQUIRE(s.min.size() == s.mean.size());
+      REQUIRE(s.max.size() == s.mean.size());
+      for (int i = 0; i < length; i++) {
+        double total = 0;
+        float low = nyc->averageMaxes()[i], high = low;
+        for (int j = i; j < i + s.window; j++) {
+          total += nyc->averageMaxes()[j];
+          low = min(low, nyc->averageMaxes()[j]);
+          high = max(high, nyc->averageMaxes()[j]);
+        }
+        CHECK(s.mean[i] == Approx(total / s.window));
+        CHECK(s.min[i] == low);
+        CHECK(s.max[i] == high);
+      }
+    }
+  }
+
+  SECTION("Whole windows agree with the all time aggregates") {
+    RollingSeries all = rollingWindows(*nyc, CityColumn::DaysAbove90, {51})[0];
+    REQUIRE(all.mean.size() == 1);
+    CHECK(all.mean[0] * 51 == Approx(891));
+    RollingSeries single = rollingWindows(*nyc, CityColumn::DaysBelow32, {1})[0];
+    CHECK(single.mean[2] == 29);
+    CHECK(single.min[2] == 29);
+    CHECK(rollingWindows(*nyc, CityColumn::AverageMin, {51})[0].min[0] == nyc->getAllTimeMin());
+  }
+
+  SECTION("Windows have to cover a year") {
+    CHECK_THROWS_AS(rollingWindows(*nyc, CityColumn::AverageTemperature, {5, 0}),
+                    invalid_argument);
+  }
+
+  delete nyc;
+}
+
+TEST_CASE("Synthetic Data", "[Synthetic]") {
+  SyntheticOptions options;
+  options.stations = 40;
+  options.yearsPerStation = 25;
+  uintmax_t bytes = writeSyntheticData("synthetic.csv", options);
+  CHECK(MappedFile("synthetic.csv").size() == bytes);
+
+  SECTION("Quoted names survive every reader") {
+    CityMap serial = readAllCities("synthetic.csv");
+    CityMap parallel = readAllCitiesParallel("synthetic.csv", 4, 1024);
+    REQUIRE(serial.size() == 40);
+    REQUIRE(parallel.size() == 40);
+    const CityTemperatureData& first = *serial.at("USW00000000");
+    CHECK(first.getName().find(", ") != string::npos);  // e.g. "ALBANY WSO, NY US"
+    CHECK(first.count() == 25);
+    CHECK(first.getFirstYear() == 1960);
+    CHECK(parallel.at("USW00000039")->getName() == serial.at("USW00000039")->getName());
+    CHECK(parallel.at("USW00000039")->getTotalDaysBelow32()
+          == serial.at("USW00000039")->getTotalDaysBelow32());
+    for (const auto& [station, city] : serial) {
+      CHECK(city->getAllTimeMin() < city->getAllTimeAverage());
+      CHECK(city->getAllTimeAverage() < city->getAllTimeMax());
+    }
+  }
+
+  SECTION("The same options write the same file") {
+    writeSyntheticData("synthetic2.csv", options);
+    CHECK(MappedFile("synthetic.csv").view() == MappedFile("synthetic2.csv").view());
+    options.seed = 282;
+    writeSyntheticData("synthetic2.csv", options);
+    CHECK(MappedFile("synthetic.csv").view() != MappedFile("synthetic2.csv").view());
+    remove("synthetic2.csv");
+  }
+
+  remove("synthetic.csv");
+}
+
+TEST_CASE("Station Queries", "[Query]") {
+  SyntheticOptions options;
+  options.stations = 300;
+  options.yearsPerStation = 30;
+  writeSyntheticData("query.csv", options);
+  CityMap cities = readAllCities("query.csv");
+  CityList list = cityList(cities);
+  REQUIRE(list.size() == 300);
+  ThreadPool pool(4);
+
+  SECTION("Top k matches sorting every city") {
+    auto rise = trend(&CityYear::averageTemperature);
+    vector<RankedCity> top = topCities(list, 50, rise, pool);
+    REQUIRE(top.size() == 50);
+
+    vector<double> everyRise;
+    for (const CityTemperatureData* city : list) everyRise.push_back(rise(*city));
+    sort(everyRise.begin(), everyRise.end(), greater<double>());
+    for (size_t i = 0; i < top.size(); i++) {
+      CHECK(top[i].value == everyRise[i]);
+      CHECK(list[top[i].index] == top[i].city);
+    }
+    CHECK(topCities(list, 1000, rise, pool).size() == 300);
+    // room is only set aside for the cities there are, not for k of them
+    CHECK(topCities(list, numeric_limits<size_t>::max(), rise, pool).size() == 300);
+    CHECK(topCities(list, 0, rise, pool).empty());
+    CHECK(topCities(CityList(), 5, rise, pool).empty());
+  }
+
+  SECTION("Trends are least squares slopes") {
+    float line[] = {1.0f, 3.0f, 5.0f, 7.0f};
+    CHECK(trendOf(line, 4) == Approx(2.0));
+    int flat[] = {4, 4, 4};
+    CHECK(trendOf(flat, 3) == Approx(0.0));
+    double none = trendOf(line, 1);
+    CHECK(none != none);  // NaN
+    none = trendOf(flat, 0);
+    CHECK(none != none);
+  }
+
+  SECTION("Filters match a sequential scan, in order") {
+    auto hot = anyYear([](const CityYear& year) { return year.numDaysAbove90 > 40; });
+    CityList matches = filterCities(list, hot, pool);
+    CityList expected;
+    for (const CityTemperatureData* city : list) {
+      for (int year = city->getFirstYear(); year < city->getFirstYear() + city->count(); year++) {
+        if ((*city)[year].numDaysAbove90 > 40) {
+          expected.push_back(city);
+          break;
+        }
+      }
+    }
+    CHECK(matches == expected);
+    CHECK(!matches.empty());
+    CHECK(matches.size() < list.size());
+    auto recent = everyYear([](const CityYear& year) { return year.year >= 1960; });
+    CHECK(filterCities(list, recent, pool).size() == 300);
+  }
+
+  SECTION("Projections over the real data") {
+    CityTemperatureData* nyc = readCity("NYC", "tempdata.csv", 1, 51);
+    CHECK(largest(&CityYear::numDaysAbove90)(*nyc) == maxColumn(nyc->daysAbove90(), 51));
+    CHECK(trend(&CityYear::averageMin)(*nyc) > 0);  // the city has been warming
+    delete nyc;
+  }
+
+  SECTION("A city without years has no largest value and isn't ranked") {
+    CityTemperatureData empty("Empty");
+    double value = largest(&CityYear::averageMax)(empty);
+    CHECK(value != value);  // NaN
+    CityList withEmpty = {&empty, list[0], list[1]};
+    vector<RankedCity> top = topCities(withEmpty, 3, largest(&CityYear::averageMax), pool);
+    REQUIRE(top.size() == 2);
+    CHECK(top[0].city != &empty);
+    CHECK(top[1].city != &empty);
+  }
+
+  SECTION("A city with a single year has no trend and isn't ranked") {
+    CityTemperatureData single("Single");
+    single.append((*list[0])[list[0]->getFirstYear()]);
+    double value = trend(&CityYear::averageTemperature)(single);
+    CHECK(value != value);  // NaN
+    CityList withSingle = {list[0], &single, list[1]};
+    vector<RankedCity> top = topCities(withSingle, 3, trend(&CityYear::averageTemperature), pool);
+    REQUIRE(top.size() == 2);
+    CHECK(top[0].city != &single);
+    CHECK(top[1].city != &single);
+  }
+
+  remove("query.csv");
+}
+
+// A record with a different layout than CityYear, to map columns onto
+struct StationSummary {
+  string_view station;
+  string name;
+  float averageMax;
+  int year;
+};
+
+TEST_CASE("Schema Mapped Parsing", "[Schema]") {
+  MappedFile file("tempdata.csv");
+
+  SECTION("The tempdata schema matches parseLine") {
+    vector<CityYear> years = readRecords(file.view(), cityYearSchema());
+    REQUIRE(years.size() == 102);
+    CsvIndex index("tempdata.csv", false);
+    for (int i = 0; i < 102; i++) {
+      CityYear expected = parseLine(index.line(i + 1));
+      CHECK(years[i].year == expected.year);
+      CHECK(years[i].numDaysBelow32 == expected.numDaysBelow32);
+      CHECK(years[i].numDaysAbove90 == expected.numDaysAbove90);
+      CHECK(years[i].averageTemperature == expected.averageTemperature);
+      CHECK(years[i].averageMax == expected.averageMax);
+      CHECK(years[i].averageMin == expected.averageMin);
+    }
+  }
+
+  SECTION("Columns can come in any order and extra ones are skipped") {
+    string csv
+        = "\"TMAX\",\"ELEVATION\",\"NAME\",\"DATE\",\"STATION\"\n"
+          "\"62.0\",\"42.7\",\"NY CITY CENTRAL PARK, NY US\",\"1968\",\"USW00094728\"\n"
+          "\"56.9\",\"100.6\",\"BURLINGTON INTERNATIONAL AIRPORT, VT US\",\"2018\",\"USW00014742\"\n";
+    auto schema = CsvSchema(field<&StationSummary::year>("DATE"),
+                            field<&StationSummary::station>("STATION"),
+                            field<&StationSummary::name>("NAME"),
+                            field<&StationSummary::averageMax>("TMAX"));
+    vector<StationSummary> rows = readRecords(csv, schema);
+    REQUIRE(rows.size() == 2);
+    CHECK(rows[0].station == "USW00094728");
+    CHECK(rows[0].name == "NY CITY CENTRAL PARK, NY US");
+    CHECK(rows[0].averageMax == 62.0f);
+    CHECK(rows[1].year == 2018);
+    CHECK(rows[1].name == "BURLINGTON INTERNATIONAL AIRPORT, VT US");
+  }
+
+  SECTION("Missing columns and bad cells are reported") {
+    auto schema = cityYearSchema();
+    CHECK_THROWS_AS(schema.resolve("\"STATION\",\"DATE\",\"TAVG\""), runtime_error);
+    CHECK(!schema.resolved());
+    schema.resolve("\"DATE\",\"DX32\",\"DX90\",\"TAVG\",\"TMAX\",\"TMIN\"");
+    CityYear year = {};
+    CHECK(schema.parse("\"2001\",\"3\",\"x\",\"50\",\"60\",\"40\"", year) == CellError::Malformed);
+    CHECK(year.numDaysBelow32 == 3);
+    CHECK(year.averageTemperature == 0);
+    CHECK(schema.parse("\"2001\",\"3\",\"4\"", year) == CellError::Empty);
+    CHECK_THROWS_AS(readRecords("DATE\n20x1\n", CsvSchema(field<&CityYear::year>("DATE"))),
+                    invalid_argument);
+  }
+}
+
+// Gather the batches of a stream back into cities, noting the largest batch
+static size_t gather(CsvStream& stream, CityMap& cities, size_t& largestBatch) {
+  largestBatch = 0;
+  return stream.readAll([&](const string& station, const string& name,
+                            const vector<CityYear>& years) {
+    largestBatch = max(largestBatch, years.size());
+    auto& city = cities[station];
+    if (city == nullptr) city = make_unique<CityTemperatureData>(name);
+    for (const CityYear& year : years) city->append(year);
+  });
+}
+
+TEST_CASE("Streaming Reader", "[Stream]") {
+  SECTION("Small batches through a small buffer") {
+    CityMap cities;
+    size_t largestBatch;
+    ifstream file("tempdata.csv", ios::binary);
+    CsvStream stream(file, 10, 128);
+    CHECK(gather(stream, cities, largestBatch) == 102);
+    CHECK(largestBatch == 10);
+    REQUIRE(cities.size() == 2);
+    CityTemperatureData& nyc = *cities.at("USW00094728");
+    CHECK(nyc.getName() == "NY CITY CENTRAL PARK");
+    CHECK(nyc.count() == 51);
+    CHECK(nyc.getTotalDaysAbove90() == 891);
+    CHECK(cities.at("USW00014742")->getTotalDaysBelow32() == 3242);
+  }
+
+  SECTION("Quoted names and no newline at the end") {
+    SyntheticOptions options;
+    options.stations = 50;
+    options.yearsPerStation = 12;
+    writeSyntheticData("stream.csv", options);
+    string text(MappedFile("stream.csv").view());
+    text.pop_back();  // the last newline
+    istringstream in(text);
+    CsvStream stream(in, 7, 200);
+    CityMap cities;
+    size_t largestBatch;
+    CHECK(gather(stream, cities, largestBatch) == 600);
+    CHECK(largestBatch <= 7);
+    CityMap expected = readAllCities("stream.csv");
+    REQUIRE(cities.size() == expected.size());
+    for (const auto& [station, city] : expected) {
+      CHECK(cities.at(station)->getName() == city->getName());
+      CHECK(cities.at(station)->getTotalDaysAbove90() == city->getTotalDaysAbove90());
+    }
+    remove("stream.csv");
+  }
+
+  SECTION("A newline inside quotes doesn't end the record") {
+    istringstream in(
+        "STATION,NAME,DATE,DX32,DX90,TAVG,TMAX,TMIN\n"
+        "\"S1\",\"TWO\nLINES\",\"2000\",\"1\",\"2\",\"50.0\",\"60.0\",\"40.0\"\n");
+    CsvStream stream(in, 4, 64);
+    CityMap cities;
+    size_t largestBatch;
+    CHECK(gather(stream, cities, largestBatch) == 1);
+    CHECK(cities.at("S1")->getName() == "TWO\nLINES");
+  }
+
+#ifndef _WIN32
+  SECTION("Reading a pipe") {
+    int ends[2];
+    REQUIRE(pipe(ends) == 0);
+    thread writer([&] {
+      MappedFile file("tempdata.csv");
+      for (size_t done = 0; done < file.size();) {
+        ssize_t written = write(ends[1], file.data() + done, min<size_t>(file.size() - done, 100));
+        if (written <= 0) break;
+        done += written;
+      }
+      close(ends[1]);
+    });
+    CsvStream stream(ends[0], 32, 256);
+    CityMap cities;
+    size_t largestBatch;
+    CHECK(gather(stream, cities, largestBatch) == 102);
+    writer.join();
+    close(ends[0]);
+    CHECK(largestBatch == 32);
+    CHECK(cities.at("USW00094728")->getTotalDaysBelow32() == 967);
+  }
+#endif
+
+  SECTION("Records have to fit in the buffer") {
+    ifstream file("tempdata.csv", ios::binary);
+    CsvStream stream(file, 10, 16);
+    CityMap cities;
+    size_t largestBatch;
+    CHECK_THROWS_AS(gather(stream, cities, largestBatch), length_error);
+  }
+}
@@ -0,0 +1,91 @@
+//
+//  cascade_bench.cpp
+//
+//  Time to find keys in each of many sorted arrays: a binarySearch() in
+//  each against one FractionalCascade. Usage: assignment02_cascade_bench
+//  [arrays] [length...]
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>  // for shuffle()
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "FractionalCascade.h"
+#include "search.h"
+#include "util.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace csi281;
+
+static const int NUM_KEYS = 100000;
+
+int main(int argc, char *argv[]) {
+  const int count = argc > 1 ? atoi(argv[1]) : 32;
+  vector<int> sizes;
+  for (int i = 2; i < argc; i++) sizes.push_back(atoi(argv[i]));
+  if (sizes.empty()) sizes = {10000, 100000, 1000000};
+
+  cout << "arrays, n, build ms, binarySearch ns, branchless ns, cascade ns (per key, all arrays)"
+       << endl;
+  for (int length : sizes) {
+    vector<int *> arrays(count);
+    vector<int> lengths(count, length);
+    for (int i = 0; i < count; i++) arrays[i] = randomIntArray(length, 0, 4 * length, i);
+    int *keys = randomIntArray(NUM_KEYS, 0, 4 * length, count);
+    shuffle(keys, keys + NUM_KEYS, mt19937(281));
+
+    auto start = steady_clock::now();
+    FractionalCascade<int> cascade(arrays.data(), lengths.data(), count);
+    double buildMs = duration<double, milli>(steady_clock::now() - start).count();
+
+    vector<int> found(count);
+    long long sum = 0;
+    start = steady_clock::now();
+    for (int k = 0; k < NUM_KEYS; k++) {
+      for (int i = 0; i < count; i++) sum += binarySearch(arrays[i], length, keys[k]);
+    }
+    nanoseconds binary = (steady_clock::now() - start) / NUM_KEYS;
+    start = steady_clock::now();
+    for (int k = 0; k < NUM_KEYS; k++) {
+      for (int i = 0; i < count; i++) sum += branchlessBinarySearch(arrays[i], length, keys[k]);
+    }
+    nanoseconds branchless = (steady_clock::now() - start) / NUM_KEYS;
+    start = steady_clock::now();
+    for (int k = 0; k < NUM_KEYS; k++) {
+      cascade.search(keys[k], found.data());
+      for (int i = 0; i < count; i++) sum += found[i];
+    }
+    nanoseconds cascaded = (steady_clock::now() - start) / NUM_KEYS;
+    doNotOptimize(sum);
+
+    cout << count << ", " << length << ", " << buildMs << ", " << binary.count() << ", "
+         << branchless.count() << ", " << cascaded.count() << endl;
+    for (int *array : arrays) delete[] array;
+    delete[] keys;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+//
+//  fixture_bench.cpp
+//
+//  Time to make the sorted random arrays the search benchmarks use:
+//  one mt19937 and sort() against randomIntArray()'s counter based
+//  generator and parallelRadixSort(). Pass the array sizes as arguments.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>  // for sort()
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "util.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace csi281;
+
+static double millisecondsSince(const steady_clock::time_point start) {
+  return duration<double, milli>(steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  vector<long long> sizes;
+  for (int i = 1; i < argc; i++) sizes.push_back(atoll(argv[i]));
+  if (sizes.empty()) sizes = {1000000, 10000000, 100000000};
+
+  cout << thread::hardware_concurrency() << " hardware threads" << endl;
+  cout << "n, mt19937 ms, sort() ms, parallelRadixSort() ms, seeded randomIntArray() ms" << endl;
+  for (long long size : sizes) {
+    const int length = static_cast<int>(size);
+
+    // the way randomIntArray() used to do it
+    vector<int> values(length);
+    auto start = steady_clock::now();
+    mt19937 generator(281);
+    uniform_int_distribution<> distribution(0, length);
+    for (int &value : values) value = distribution(generator);
+    double generateMs = millisecondsSince(start);
+
+    vector<int> copy = values;
+    start = steady_clock::now();
+    sort(values.begin(), values.end());
+    double sortMs = millisecondsSince(start);
+    start = steady_clock::now();
+    parallelRadixSort(copy.data(), length);
+    double radixMs = millisecondsSince(start);
+    if (copy != values) cout << "parallelRadixSort() disagrees with sort()!" << endl;
+
+    // generating and sorting
+    start = steady_clock::now();
+    int *array = randomIntArray(length, 0, length, 281);
+    double seededMs = millisecondsSince(start);
+    delete[] array;
+
+    cout << length << ", " << generateMs << ", " << sortMs << ", " << radixMs << ", " << seededMs
+         << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+//
+//  stree_bench.cpp
+//
+//  Lookup time of STree against binarySearch() and EytzingerIndex on
+//  large random arrays. Pass the array sizes to run as arguments.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>  // for shuffle()
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "EytzingerIndex.h"
+#include "STree.h"
+#include "search.h"
+#include "util.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace csi281;
+
+static const int NUM_KEYS = 1000000;
+
+int main(int argc, char *argv[]) {
+  vector<long long> sizes;
+  for (int i = 1; i < argc; i++) sizes.push_back(atoll(argv[i]));
+  if (sizes.empty()) sizes = {1000000, 10000000, 100000000};
+
+  cout << "n, build ms, tree MB, binarySearch ns, branchless ns, eytzinger ns, s-tree ns" << endl;
+  for (long long size : sizes) {
+    const int length = static_cast<int>(size);
+    int *array = randomIntArray(length, 0, length);
+    int *keys = randomIntArray(NUM_KEYS, 0, length);
+    shuffle(keys, keys + NUM_KEYS, mt19937(281));
+
+    auto start = steady_clock::now();
+    STree<int> tree(array, length);
+    double buildMs = duration<double, milli>(steady_clock::now() - start).count();
+
+    nanoseconds binary = averageSearchTime(array, length, keys, NUM_KEYS, binarySearch<int>);
+    nanoseconds branchless
+        = averageSearchTime(array, length, keys, NUM_KEYS, branchlessBinarySearch<true, int>);
+    nanoseconds eytzinger;
+    {
+      EytzingerIndex<int> index(array, length);
+      eytzinger = averageSearchTime(array, length, keys, NUM_KEYS,
+                                    [&index](int[], const int, const int key) {
+                                      return index.search(key);
+                                    });
+    }
+    nanoseconds stree = averageSearchTime(
+        array, length, keys, NUM_KEYS,
+        [&tree](int[], const int, const int key) { return tree.search(key); });
+
+    cout << length << ", " << buildMs << ", " << tree.sizeBytes() / 1048576.0 << ", "
+         << binary.count() << ", " << branchless.count() << ", " << eytzinger.count() << ", "
+         << stree.count() << endl;
+    delete[] array;
+    delete[] keys;
+  }
+  return 0;
+}
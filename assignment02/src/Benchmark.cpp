@@ -0,0 +1,115 @@
+//
+//  Benchmark.cpp
+//
+//  Repeated, percentile based timing of the searches, with the caches
+//  either warm or flushed, and CSV output of the results.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>  // for ceil()
+#include <random>
+
+using namespace std;
+
+namespace csi281 {
+
+  // Push the array and keys out of every level of cache by writing to a
+  // line in each 64 bytes of something bigger
+  static void evictCaches(vector<unsigned char> &scratch) {
+    for (size_t i = 0; i < scratch.size(); i += 64) scratch[i]++;
+    doNotOptimize(scratch.data());
+  }
+
+  // Average time of timer over each key searched alone with cold caches.
+  // Flushing takes far longer than a search, so it stays outside the timing.
+  static nanoseconds coldSearchTime(const SearchTimer &timer, int array[], const int length,
+                                    const int keys[], const int numKeys,
+                                    vector<unsigned char> &scratch) {
+    nanoseconds total(0);
+    for (int i = 0; i < numKeys; i++) {
+      evictCaches(scratch);
+      total += timer(array, length, keys + i, 1);
+    }
+    return total / max(1, numKeys);
+  }
+
+  vector<SearchStats> searchStats(const vector<SearchTimer> &timers, const int length,
+                                  const int numKeys, const BenchmarkOptions &options) {
+    int *testArray = randomIntArray(length, 0, length);
+    int *testKeys = randomIntArray(numKeys, 0, length);
+    // randomIntArray() sorts, which would let each search reuse the path
+    // (and the branch predictions) of the one before it
+    shuffle(testKeys, testKeys + numKeys, mt19937(281));
+
+    for (int w = 0; w < options.warmups; w++) {
+      for (const SearchTimer &timer : timers) timer(testArray, length, testKeys, numKeys);
+    }
+
+    vector<unsigned char> scratch(options.cache == CacheMode::Cold ? options.evictBytes : 0);
+    vector<vector<nanoseconds>> times(timers.size());
+    for (int r = 0; r < options.repetitions; r++) {
+      for (size_t t = 0; t < timers.size(); t++) {
+        if (options.cache == CacheMode::Cold) {
+          times[t].push_back(
+              coldSearchTime(timers[t], testArray, length, testKeys, numKeys, scratch));
+        } else {
+          times[t].push_back(timers[t](testArray, length, testKeys, numKeys));
+        }
+      }
+    }
+    delete[] testArray;
+    delete[] testKeys;
+
+    vector<SearchStats> stats;
+    for (const vector<nanoseconds> &runs : times) {
+      nanoseconds total(0);
+      for (nanoseconds run : runs) total += run;
+      nanoseconds mean = total / max<nanoseconds::rep>(1, runs.size());
+      stats.push_back({percentile(runs, 50), percentile(runs, 90), percentile(runs, 99), mean});
+    }
+    return stats;
+  }
+
+  nanoseconds percentile(vector<nanoseconds> times, const double percent) {
+    if (times.empty()) return nanoseconds(0);
+    sort(times.begin(), times.end());
+    size_t rank = static_cast<size_t>(ceil(percent / 100 * times.size()));
+    return times[min(max<size_t>(rank, 1), times.size()) - 1];
+  }
+
+  const char *cacheModeName(const CacheMode cache) {
+    return cache == CacheMode::Cold ? "cold" : "warm";
+  }
+
+  void writeSearchCsvHeader(ostream &out) { out << "search,cache,n,p50,p90,p99,mean" << endl; }
+
+  void writeSearchCsv(ostream &out, const string &name, const CacheMode cache, const int length,
+                      const SearchStats &stats) {
+    // names can have commas in them
+    out << '"' << name << "\"," << cacheModeName(cache) << ',' << length << ','
+        << stats.p50.count() << ',' << stats.p90.count() << ',' << stats.p99.count() << ','
+        << stats.mean.count() << endl;
+  }
+}  // namespace csi281
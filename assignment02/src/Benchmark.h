@@ -0,0 +1,85 @@
+//
+//  Benchmark.h
+//
+//  Repeated, percentile based timing of the searches, with the caches
+//  either warm or flushed, and CSV output of the results.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+#include "util.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace csi281 {
+  // Whether a timed search finds the array already in the cache (left there
+  // by the searches before it) or has to fetch it from memory. Cold searches
+  // are timed one at a time, each right after the caches are flushed, so
+  // they include the clock's overhead and give a batched search nothing to
+  // overlap; a cold repetition is the average of those single searches.
+  enum class CacheMode { Warm, Cold };
+
+  struct BenchmarkOptions {
+    // untimed runs first, to fill the caches and train the branch predictor
+    int warmups = 3;
+    // timed runs; the percentiles are taken over these
+    int repetitions = 100;
+    CacheMode cache = CacheMode::Warm;
+    // written through before each Cold search; more than a last level cache holds
+    size_t evictBytes = 64 * 1024 * 1024;
+  };
+
+  // Average time per search of the timed repetitions
+  struct SearchStats {
+    nanoseconds p50, p90, p99, mean;
+  };
+
+  // Time each way of searching in timers over numKeys random keys, all in
+  // the same random array of *length*. Each repetition runs every timer
+  // once, in turn, so a change in clock speed partway through hits all of
+  // them alike.
+  vector<SearchStats> searchStats(const vector<SearchTimer> &timers, const int length,
+                                  const int numKeys, const BenchmarkOptions &options = {});
+
+  // The time that percent of times are at or under (nearest rank)
+  nanoseconds percentile(vector<nanoseconds> times, const double percent);
+
+  const char *cacheModeName(const CacheMode cache);
+
+  // One line per search and length, in nanoseconds:
+  // search,cache,n,p50,p90,p99,mean
+  void writeSearchCsvHeader(ostream &out);
+  void writeSearchCsv(ostream &out, const string &name, const CacheMode cache, const int length,
+                      const SearchStats &stats);
+}  // namespace csi281
+
+#endif /* Benchmark_hpp */
@@ -0,0 +1,111 @@
+//
+//  EytzingerIndex.h
+//
+//  Static search index over a sorted array, stored in Eytzinger (breadth
+//  first) order so searches walk down cache friendly and prefetchable.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef EytzingerIndex_hpp
+#define EytzingerIndex_hpp
+
+#include <algorithm>  // for max()
+#include <bit>        // for countr_one()
+#include <cstddef>
+#include <cstdint>  // for uintptr_t
+#include <new>  // for align_val_t
+#include <type_traits>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+#include "search.h"
+
+using namespace std;
+
+namespace csi281 {
+  // A copy of a sorted array laid out as an implicit binary tree: the root
+  // is slot 1 and the children of slot k are 2k and 2k + 1. The top levels
+  // share a few cache lines, and the 16 descendants four levels below a slot
+  // (for ints) sit in one cache line, so a search prefetches four levels ahead.
+  template <typename T> class EytzingerIndex {
+  public:
+    EytzingerIndex(const T sorted[], const int length)
+        : _length(length), _positions(length + 1), _tree(allocate(length)) {
+      build(sorted, 0, 1);
+    }
+
+    ~EytzingerIndex() { ::operator delete(_tree, align_val_t(CACHE_LINE)); }
+
+    EytzingerIndex(const EytzingerIndex &) = delete;
+    EytzingerIndex &operator=(const EytzingerIndex &) = delete;
+
+    int size() const { return _length; }
+
+    // Returns the first location of the found key in the sorted array the
+    // index was built from, or -1 if the key is never found, like
+    // binarySearch()
+    int search(const T key) const {
+      size_t k = 1;
+      while (k <= static_cast<size_t>(_length)) {
+        // a prefetch never faults, so near the leaves it may point past the
+        // end; going through an integer keeps the pointer math defined
+        CSI281_PREFETCH(reinterpret_cast<const T *>(reinterpret_cast<uintptr_t>(_tree)
+                                                    + k * PREFETCH_SPAN * sizeof(T)));
+        k = 2 * k + (_tree[k] < key);
+      }
+      // going right means the key is larger; undo the right turns taken
+      // after the last left turn to get back to the lower bound
+      k >>= countr_one(k) + 1;
+      if (k == 0 || _tree[k] != key) return -1;
+      return _positions[k];
+    }
+
+  private:
+    static_assert(is_trivially_copyable_v<T>, "the index keeps raw copies of the keys");
+    static constexpr size_t CACHE_LINE = 64;
+    // the descendants of slot k some levels down start at slot k * PREFETCH_SPAN
+    // and fill exactly one cache line
+    static constexpr size_t PREFETCH_SPAN = max<size_t>(1, CACHE_LINE / sizeof(T));
+
+    static T *allocate(const int length) {
+      size_t bytes = (static_cast<size_t>(length) + 1) * sizeof(T);
+      return static_cast<T *>(::operator new(bytes, align_val_t(CACHE_LINE)));
+    }
+
+    // An in-order walk of the tree hands out the sorted keys in order
+    int build(const T sorted[], int next, const size_t k) {
+      if (k <= static_cast<size_t>(_length)) {
+        next = build(sorted, next, 2 * k);
+        _tree[k] = sorted[next];
+        _positions[k] = next++;
+        next = build(sorted, next, 2 * k + 1);
+      }
+      return next;
+    }
+
+    int _length;
+    vector<int> _positions;  // where each slot's key is in the sorted array
+    T *_tree;                // slot 0 is unused
+  };
+}  // namespace csi281
+
+#endif /* EytzingerIndex_hpp */
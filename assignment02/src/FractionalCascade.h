@@ -0,0 +1,143 @@
+//
+//  FractionalCascade.h
+//
+//  Fractional cascading: finds a key in each of many sorted arrays with
+//  one binary search.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FractionalCascade_hpp
+#define FractionalCascade_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+
+using namespace std;
+
+namespace csi281 {
+  // Searches for a key in count sorted arrays at once in O(log n + count)
+  // instead of the O(count log n) of a binary search in each. Level i is a
+  // merge of arrays[i] with every other key of level i + 1, and each of its
+  // keys records where it would go in arrays[i] and in level i + 1. One
+  // binary search finds where the key goes in level 0; from then on the
+  // place in the next level is at most a step or two before the recorded
+  // one, because between the key and the place found there is no key that
+  // was copied up, and those are every other key of the level below.
+  // The levels have at most twice as many keys as the arrays. The arrays
+  // aren't copied, so they have to outlive the cascade and not change.
+  template <typename T> class FractionalCascade {
+  public:
+    FractionalCascade(const T *const arrays[], const int lengths[], const int count)
+        : _arrays(arrays, arrays + count), _lengths(lengths, lengths + count), _starts(count + 1) {
+      // a level holds its array, every other key of the level below (which
+      // holds a sentinel that isn't copied) and its own sentinel
+      vector<size_t> sizes(count);
+      for (int i = count - 1; i >= 0; i--) {
+        sizes[i] = lengths[i] + (i + 1 < count ? (sizes[i + 1] - 1) / 2 : 0) + 1;
+      }
+      for (int i = 0; i < count; i++) _starts[i + 1] = _starts[i] + sizes[i];
+      _entries.resize(_starts[count]);
+      // each level is made from the one below it
+      for (int i = count - 1; i >= 0; i--) buildLevel(i);
+    }
+
+    // How many arrays
+    int size() const { return static_cast<int>(_arrays.size()); }
+
+    // Writes the first location of key in each array, or -1 if it isn't in
+    // that array, to out[0] through out[size() - 1], like
+    // branchlessBinarySearch() on each array would
+    void search(const T key, int out[]) const {
+      if (_arrays.empty()) return;
+      // where key goes among the first level (not counting its sentinel)
+      const Entry *level = _entries.data();
+      int place = 0;
+      int remaining = static_cast<int>(_starts[1]) - 1;
+      if (remaining > 0) {
+        while (remaining > 1) {
+          int half = remaining / 2;
+          place += (level[place + half].key < key) * half;
+          remaining -= half;
+        }
+        place += level[place].key < key;
+      }
+      for (size_t i = 0; i < _arrays.size(); i++) {
+        // on a tie the array's own keys come first, so if key is in the
+        // array, this is it
+        const Entry &entry = level[place];
+        out[i] = entry.mine && entry.key == key ? entry.own : -1;
+        if (i + 1 < _arrays.size()) {
+          level = _entries.data() + _starts[i + 1];
+          place = entry.down;
+          while (place > 0 && !(level[place - 1].key < key)) place--;
+        }
+      }
+    }
+
+  private:
+    struct Entry {
+      T key;
+      int own;    // where key would go in this level's array (the first not less)
+      int down;   // where key would go in the next level
+      bool mine;  // whether key came from this level's array or was copied up
+    };
+
+    // Merges arrays[i] with every other key of the level below and records
+    // where each key goes in both. The last entry is a sentinel past the end
+    // of both.
+    void buildLevel(const int i) {
+      const T *array = _arrays[i];
+      const int length = _lengths[i];
+      const bool last = i + 1 == size();
+      const Entry *below = last ? nullptr : _entries.data() + _starts[i + 1];
+      const int belowLength = last ? 0 : static_cast<int>(_starts[i + 2] - _starts[i + 1]) - 1;
+      Entry *level = _entries.data() + _starts[i];
+      int own = 0, down = 0;     // the first places not less than the current key
+      int next = 0, copied = 1;  // the next key to take from each
+      while (next < length || copied < belowLength) {
+        // on a tie take the array's key first
+        bool fromArray
+            = copied >= belowLength || (next < length && !(below[copied].key < array[next]));
+        T key;
+        if (fromArray) {
+          key = array[next++];
+        } else {
+          key = below[copied].key;
+          copied += 2;
+        }
+        while (own < length && array[own] < key) own++;
+        while (down < belowLength && below[down].key < key) down++;
+        *level++ = {key, own, down, fromArray};
+      }
+      *level = {T(), length, belowLength, false};
+    }
+
+    vector<const T *> _arrays;
+    vector<int> _lengths;
+    vector<size_t> _starts;  // where each level begins in _entries
+    vector<Entry> _entries;  // every level, first to last
+  };
+}  // namespace csi281
+
+#endif /* FractionalCascade_hpp */
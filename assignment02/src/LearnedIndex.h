@@ -0,0 +1,129 @@
+//
+//  LearnedIndex.h
+//
+//  Learned index over a sorted array: a piecewise linear model from key
+//  to position with a guaranteed maximum error.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LearnedIndex_hpp
+#define LearnedIndex_hpp
+
+#include <algorithm>  // for min() and max()
+#include <cmath>      // for floor()
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryLeakDetector.h"
+#include "search.h"
+
+using namespace std;
+
+namespace csi281 {
+  // Predicts where a key is in a sorted array with a few straight lines,
+  // each fitted in a single pass over the array by the shrinking cone
+  // method: a line starts at a key and the range of slopes that keeps every
+  // key since within maxError places of its first position narrows with each
+  // key, until a key would empty it and starts the next line. A lookup finds
+  // its line among the few line starts, predicts a position and finishes with
+  // a binary search of the 2 * maxError + 1 places around it. The model is a
+  // key, a slope and a position per line, far smaller than a B-tree's nodes.
+  // The array isn't copied, so it has to outlive the index and not change.
+  template <typename T> class LearnedIndex {
+  public:
+    LearnedIndex(const T sorted[], const int length, const int maxError = 32)
+        : _array(sorted), _length(length), _maxError(maxError) {
+      static_assert(is_arithmetic_v<T>, "the model needs numbers to fit lines to");
+      int first = 0;  // position of the key the current line starts at
+      double lowSlope = 0, highSlope = numeric_limits<double>::infinity();
+      for (int i = 1; i < length; i++) {
+        if (sorted[i] == sorted[i - 1]) continue;  // only first positions are modeled
+        double dx = static_cast<double>(sorted[i]) - static_cast<double>(sorted[first]);
+        double low = max(lowSlope, (i - first - maxError) / dx);
+        double high = min(highSlope, (i - first + maxError) / dx);
+        if (low <= high) {
+          lowSlope = low;
+          highSlope = high;
+        } else {
+          addLine(first, lowSlope, highSlope);
+          first = i;
+          lowSlope = 0;
+          highSlope = numeric_limits<double>::infinity();
+        }
+      }
+      if (length > 0) addLine(first, lowSlope, highSlope);
+    }
+
+    // Returns the first location of the found key or -1 if the key is
+    // never found, like branchlessBinarySearch()
+    int search(const T key) const {
+      if (_length == 0 || key < _firstKeys.front()) return -1;
+      // the last line starting at or before key, found without branches
+      // the same way branchlessBinarySearch() does
+      const T *base = _firstKeys.data();
+      for (size_t remaining = _firstKeys.size(); remaining > 1;) {
+        size_t half = remaining / 2;
+        base += (base[half] <= key) * half;
+        remaining -= half;
+      }
+      size_t line = base - _firstKeys.data();
+      double dx = static_cast<double>(key) - static_cast<double>(_firstKeys[line]);
+      double predicted = _firstPositions[line] + _slopes[line] * dx;
+      // one place of slack either way for rounding in the prediction
+      long long middle = static_cast<long long>(floor(predicted));
+      long long low = max(0LL, middle - _maxError - 1);
+      long long high = min(static_cast<long long>(_length) - 1, middle + _maxError + 1);
+      if (low > high) return -1;
+      int size = static_cast<int>(high - low + 1);
+      int found = branchlessBinarySearch<false, const T>(_array + low, size, key);
+      return found == -1 ? -1 : static_cast<int>(low) + found;
+    }
+
+    int lineCount() const { return static_cast<int>(_firstKeys.size()); }
+    int maxError() const { return _maxError; }
+    // Size of the model, not counting the array it indexes
+    size_t sizeBytes() const {
+      return _firstKeys.size() * (sizeof(T) + sizeof(double) + sizeof(int));
+    }
+
+  private:
+    // Any slope between the bounds keeps every key of the line close enough;
+    // a line of one key (no upper bound) stays flat
+    void addLine(const int first, const double lowSlope, const double highSlope) {
+      _firstKeys.push_back(_array[first]);
+      _firstPositions.push_back(first);
+      _slopes.push_back(highSlope == numeric_limits<double>::infinity()
+                            ? lowSlope
+                            : (lowSlope + highSlope) / 2);
+    }
+
+    const T *_array;
+    int _length;
+    int _maxError;
+    vector<T> _firstKeys;  // kept apart from the rest so finding the line is a dense search
+    vector<int> _firstPositions;
+    vector<double> _slopes;
+  };
+}  // namespace csi281
+
+#endif /* LearnedIndex_hpp */
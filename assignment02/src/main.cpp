@@ -28,55 +28,92 @@
 //  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 //  OTHER DEALINGS IN THE SOFTWARE.
 
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
+#include "Benchmark.h"
 #include "PPlot.h"
 #include "SVGPainter.h"
+#include "search.h"
 #include "util.h"
 
 using namespace std;
 using namespace csi281;
 using namespace SVGChart;
 
-// Draw a chart showing the average search times
-// for different numbers of elements in "SearchChart.svg"
-static void drawSearchChart() {
-  PPlot pplot;
-  pplot.mPlotBackground.mTitle = "Number of Elements Versus Time (1000 samples at each N)";
-
-  PlotData *theX1 = new PlotData();
-  PlotData *theY1 = new PlotData();
-  LineDataDrawer *theDataDrawer1 = new LineDataDrawer();
-  theDataDrawer1->mDrawPoint = false;
-  theDataDrawer1->mDrawLine = true;
+// One line of the search chart
+struct SearchSeries {
+  string name;
+  PColor color;
+  SearchTimer timer;
+};
 
-  LegendData *legend1 = new LegendData();  // let us setup the first legend
-  legend1->mName = "Linear Search";
-  legend1->mColor = PColor(200, 0, 100);  // just an rgb value
+static const SearchSeries SEARCH_SERIES[] = {
+    {"Linear Search", PColor(200, 0, 100), eachKey(linearSearch<int>)},
+    {"Binary Search (w/ Sort Amortized)", PColor(100, 20, 220), eachKey(binarySearch<int>)},
+    {"Branchless Binary Search", PColor(0, 150, 100), eachKey(branchlessBinarySearch<false, int>)},
+    {"Branchless Binary Search + Prefetch", PColor(220, 140, 0),
+     eachKey(branchlessBinarySearch<true, int>)},
+    {"Batched Binary Search", PColor(0, 100, 220), batchedKeys()},
+    {"Interpolation Search", PColor(120, 120, 0), eachKey(interpolationSearch<int>)},
+    {"Exponential Search (from the middle)", PColor(120, 60, 30),
+     eachKey([](int array[], const int length, const int key) {
+       return exponentialSearch(array, length, key, length / 2);
+     })},
+};
 
-  PlotData *theX2 = new PlotData();
-  PlotData *theY2 = new PlotData();
-  LineDataDrawer *theDataDrawer2 = new LineDataDrawer();
-  theDataDrawer2->mDrawPoint = false;
-  theDataDrawer2->mDrawLine = true;
+// Draw a chart showing the median search times for different numbers of
+// elements in "SearchChart.svg", and write those and the times with cold
+// caches to "SearchTimes.csv"
+static void drawSearchChart() {
+  PPlot pplot;
+  pplot.mPlotBackground.mTitle = "Number of Elements Versus Median Time (100 x 1000 searches)";
 
-  LegendData *legend2 = new LegendData();  // let us setup the first legend
-  legend2->mName = "Binary Search (w/ Sort Amortized)";
-  legend2->mColor = PColor(100, 20, 220);  // just an rgb value
+  vector<SearchTimer> timers;
+  vector<PlotData *> xs, ys;
+  for (const SearchSeries &series : SEARCH_SERIES) {
+    timers.push_back(series.timer);
+    xs.push_back(new PlotData());
+    ys.push_back(new PlotData());
+  }
 
   cout << "Generating times for large arrays; this may take a while..." << endl;
 
   const int NUM_TESTS = 1000;
+  // every cold search waits on flushing the caches, which takes milliseconds
+  const int NUM_COLD_TESTS = 20;
+  BenchmarkOptions warm, cold;
+  cold.cache = CacheMode::Cold;
+  cold.repetitions = 10;
+  ofstream csv("SearchTimes.csv");
+  writeSearchCsvHeader(csv);
   for (int i = 100; i <= 10000; i *= 2) {
-    auto speeds = arraySearchSpeed(i, NUM_TESTS);
-    theX1->push_back(i);
-    theY1->push_back(speeds.first.count());
-    theX2->push_back(i);
-    theY2->push_back(speeds.second.count());
+    for (const BenchmarkOptions &options : {warm, cold}) {
+      int numTests = options.cache == CacheMode::Cold ? NUM_COLD_TESTS : NUM_TESTS;
+      vector<SearchStats> stats = searchStats(timers, i, numTests, options);
+      for (size_t s = 0; s < stats.size(); s++) {
+        writeSearchCsv(csv, SEARCH_SERIES[s].name, options.cache, i, stats[s]);
+        if (options.cache == CacheMode::Warm) {
+          xs[s]->push_back(i);
+          ys[s]->push_back(stats[s].p50.count());
+        }
+      }
+    }
   }
 
-  pplot.mPlotDataContainer.AddXYPlot(theX1, theY1, legend1, theDataDrawer1);
-  pplot.mPlotDataContainer.AddXYPlot(theX2, theY2, legend2, theDataDrawer2);
+  for (size_t s = 0; s < timers.size(); s++) {
+    LineDataDrawer *theDataDrawer = new LineDataDrawer();
+    theDataDrawer->mDrawPoint = false;
+    theDataDrawer->mDrawLine = true;
+
+    LegendData *legend = new LegendData();
+    legend->mName = SEARCH_SERIES[s].name;
+    legend->mColor = SEARCH_SERIES[s].color;
+
+    pplot.mPlotDataContainer.AddXYPlot(xs[s], ys[s], legend, theDataDrawer);
+  }
 
   pplot.mMargins.mLeft = 100;
   pplot.mMargins.mTop = 50;
@@ -92,7 +129,7 @@ static void drawSearchChart() {
   pplot.mYAxisSetup.mMin = 0;
   pplot.mXAxisSetup.mMin = 0;
   // pplot.mYAxisSetup.mMax = 100;
-  pplot.mYAxisSetup.mLabel = "Time (nanoseconds)";
+  pplot.mYAxisSetup.mLabel = "Median Time per Search (nanoseconds)";
   SVGPainter painter(800, 600);
   pplot.Draw(painter);
   painter.writeFile("SearchChart.svg");
@@ -0,0 +1,137 @@
+//
+//  search.cpp
+//
+//  Vectorized linear search for int, float and double, picking AVX2 when
+//  the processor has it, SSE2 otherwise on x86, and a plain loop elsewhere.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#include "search.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define CSI281_X86
+#  include <emmintrin.h>
+#  ifdef _MSC_VER
+#    include <immintrin.h>  // for _xgetbv()
+#    include <intrin.h>     // for __cpuid()
+#  endif
+#endif
+
+#include "simdSearch.h"
+
+namespace csi281 {
+  // in searchAvx2.cpp
+  bool avx2SearchCompiled();
+  int linearSearchAvx2(const int array[], const int length, const int key);
+  int linearSearchAvx2(const float array[], const int length, const float key);
+  int linearSearchAvx2(const double array[], const int length, const double key);
+
+#if defined(CSI281_X86) && (defined(__SSE2__) || defined(_M_X64) || _M_IX86_FP >= 2)
+#  define CSI281_SSE2
+  struct Sse2Int {
+    using Vec = __m128i;
+    static constexpr int LANES = 4;
+    static Vec broadcast(const int key) { return _mm_set1_epi32(key); }
+    static unsigned matches(const int *values, const Vec key) {
+      Vec loaded = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+      return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(loaded, key)));
+    }
+  };
+
+  struct Sse2Float {
+    using Vec = __m128;
+    static constexpr int LANES = 4;
+    static Vec broadcast(const float key) { return _mm_set1_ps(key); }
+    static unsigned matches(const float *values, const Vec key) {
+      return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values), key));
+    }
+  };
+
+  struct Sse2Double {
+    using Vec = __m128d;
+    static constexpr int LANES = 2;
+    static Vec broadcast(const double key) { return _mm_set1_pd(key); }
+    static unsigned matches(const double *values, const Vec key) {
+      return _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(values), key));
+    }
+  };
+#endif
+
+  // Whether the processor (and the operating system, which has to save
+  // the wider registers) supports AVX2
+  static bool cpuHasAvx2() {
+#if defined(CSI281_X86) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("avx2");
+#elif defined(CSI281_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0
+                      && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+  }
+
+  // Checked once, the first time any of the searches runs
+  static bool useAvx2() {
+    static const bool use = avx2SearchCompiled() && cpuHasAvx2();
+    return use;
+  }
+
+  template <typename T> static int scalarSearch(const T array[], const int length, const T key) {
+    for (int i = 0; i < length; i++) {
+      if (array[i] == key) return i;
+    }
+    return -1;
+  }
+
+  template <> int linearSearch<int>(int array[], const int length, const int key) {
+    if (useAvx2()) return linearSearchAvx2(array, length, key);
+#ifdef CSI281_SSE2
+    return firstMatch<Sse2Int>(array, length, key);
+#else
+    return scalarSearch(array, length, key);
+#endif
+  }
+
+  template <> int linearSearch<float>(float array[], const int length, const float key) {
+    if (useAvx2()) return linearSearchAvx2(array, length, key);
+#ifdef CSI281_SSE2
+    return firstMatch<Sse2Float>(array, length, key);
+#else
+    return scalarSearch(array, length, key);
+#endif
+  }
+
+  template <> int linearSearch<double>(double array[], const int length, const double key) {
+    if (useAvx2()) return linearSearchAvx2(array, length, key);
+#ifdef CSI281_SSE2
+    return firstMatch<Sse2Double>(array, length, key);
+#else
+    return scalarSearch(array, length, key);
+#endif
+  }
+}  // namespace csi281
@@ -29,8 +29,20 @@
 #ifndef search_hpp
 #define search_hpp
 
+#include <type_traits>  // for is_arithmetic_v
+#include <utility>      // for pair
+
 #include "MemoryLeakDetector.h"
 
+// Ask for the cache line holding address ahead of time
+#if defined(__GNUC__) || defined(__clang__)
+#  define CSI281_PREFETCH(address) __builtin_prefetch(address)
+#else
+#  include <xmmintrin.h>
+#  define CSI281_PREFETCH(address) \
+    _mm_prefetch(reinterpret_cast<const char *>(address), _MM_HINT_T0)
+#endif
+
 namespace csi281 {
 
   // Returns the first location of the found key
@@ -43,6 +55,12 @@ namespace csi281 {
   }
 
 
+  // int, float and double compare a whole vector of elements at a time
+  // (AVX2 or SSE2, picked when the program starts); see search.cpp
+  template <> int linearSearch<int>(int array[], const int length, const int key);
+  template <> int linearSearch<float>(float array[], const int length, const float key);
+  template <> int linearSearch<double>(double array[], const int length, const double key);
+
   // Returns the first location of the found key
   // or -1 if the key is never found; assumes a sorted array
   template <typename T> int binarySearch(T array[], const int length, const T key) {
@@ -63,6 +81,203 @@ namespace csi281 {
 
       return -1; // nothing found
   }
+
+  // Returns a location of the found key or -1 if the key is never found;
+  // assumes a sorted array of numbers. Each step guesses where key should
+  // be from its value, which takes about log(log(n)) steps on evenly spread
+  // data (at most 5 for any int length). On skewed data a guess can cut off
+  // very little, so after INTERPOLATION_GUESSES guesses the rest of the
+  // search takes plain binary steps, which keeps the worst case at that many
+  // steps more than binarySearch().
+  const int INTERPOLATION_GUESSES = 8;
+
+  template <typename T> int interpolationSearch(T array[], const int length, const T key) {
+    static_assert(std::is_arithmetic_v<T>, "interpolation needs numbers to divide");
+    int low = 0, high = length - 1;
+    for (int step = 0; low <= high && !(key < array[low]) && !(array[high] < key); step++) {
+      int guess;
+      if (step >= INTERPOLATION_GUESSES || array[high] == array[low]) {
+        guess = low + (high - low) / 2;
+      } else {
+        double fraction = (static_cast<double>(key) - static_cast<double>(array[low]))
+                          / (static_cast<double>(array[high]) - static_cast<double>(array[low]));
+        // NaN or out of [0, 1] when key is NaN or the ends are infinite
+        if (!(fraction >= 0 && fraction <= 1)) fraction = 0.5;
+        guess = low + static_cast<int>(fraction * (high - low));
+      }
+      if (array[guess] == key) {
+        return guess;
+      } else if (array[guess] < key) {
+        low = guess + 1;
+      } else {
+        high = guess - 1;
+      }
+    }
+    return -1;
+  }
+
+  // Returns a location of the found key or -1 if the key is never found;
+  // assumes a sorted array. Gallops away from hint in steps of 1, 2, 4, ...
+  // until it passes key and then binary searches the last step, so a key d
+  // places from hint takes about 2 log(d) steps however long the array is.
+  // The step is 64 bits, since doubling past 2^30 would overflow an int.
+  template <typename T>
+  int exponentialSearch(T array[], const int length, const T key, const int hint = 0) {
+    if (length <= 0) return -1;
+    const int start = hint < 0 ? 0 : (hint >= length ? length - 1 : hint);
+    int low, high;  // the last step, inclusive
+    if (array[start] < key) {
+      long long step = 1;
+      while (step < length - start && array[start + step] < key) step *= 2;
+      low = start + static_cast<int>(step / 2) + 1;
+      high = step < length - start ? start + static_cast<int>(step) : length - 1;
+    } else {
+      long long step = 1;
+      while (step <= start && key < array[start - step]) step *= 2;
+      low = step <= start ? start - static_cast<int>(step) : 0;
+      high = start - static_cast<int>(step / 2);
+    }
+    int found = binarySearch(array + low, high - low + 1, key);
+    return found == -1 ? -1 : low + found;
+  }
+
+  // Binary search without a branch on the comparison: the range only ever
+  // shrinks from the top, so each step is one conditional move and the
+  // number of steps depends on length alone. It finds the lower bound (the
+  // first key that isn't less than key), which is then checked for a match.
+  // With Prefetch, the two places the next step could look at are fetched
+  // while the current comparison is waiting on memory.
+  // Returns the first location of the found key or -1, like binarySearch()
+  template <bool Prefetch = false, typename T>
+  int branchlessBinarySearch(T array[], const int length, const T key) {
+    if (length <= 0) return -1;
+    const T *base = array;
+    int remaining = length;
+    while (remaining > 1) {
+      int half = remaining / 2;
+      if constexpr (Prefetch) {
+        int nextHalf = (remaining - half) / 2;
+        CSI281_PREFETCH(base + nextHalf);
+        CSI281_PREFETCH(base + half + nextHalf);
+      }
+      base = base[half] < key ? base + half : base;
+      remaining -= half;
+    }
+    int index = static_cast<int>(base - array) + (*base < key);
+    return index < length && array[index] == key ? index : -1;
+  }
+
+  // Returns the first location whose element isn't less than key, or
+  // length if there isn't one; assumes a sorted array. All of the copies of
+  // key, if there are any, start here.
+  template <typename T> int lowerBound(T array[], const int length, const T key) {
+    if (length <= 0) return 0;
+    const T *base = array;
+    for (int remaining = length; remaining > 1;) {
+      int half = remaining / 2;
+      base = base[half] < key ? base + half : base;
+      remaining -= half;
+    }
+    return static_cast<int>(base - array) + (*base < key);
+  }
+
+  // Returns the first location whose element is greater than key, or
+  // length if there isn't one; assumes a sorted array. All of the copies of
+  // key, if there are any, end just before here.
+  template <typename T> int upperBound(T array[], const int length, const T key) {
+    if (length <= 0) return 0;
+    const T *base = array;
+    for (int remaining = length; remaining > 1;) {
+      int half = remaining / 2;
+      base = key < base[half] ? base : base + half;
+      remaining -= half;
+    }
+    return static_cast<int>(base - array) + !(key < *base);
+  }
+
+  // Returns where the copies of key start and end (one past the last);
+  // they are the same place if key is never found. Both ends are searched
+  // for over the whole array: the two searches don't wait on each other,
+  // and they look at the same few places near the top, which are cached.
+  template <typename T>
+  std::pair<int, int> equalRange(T array[], const int length, const T key) {
+    return std::pair<int, int>(lowerBound(array, length, key), upperBound(array, length, key));
+  }
+
+  // Returns how many elements are from low to high, both included, in
+  // O(log n) however many there are; assumes a sorted array
+  template <typename T> int countInRange(T array[], const int length, const T low, const T high) {
+    if (high < low) return 0;
+    return upperBound(array, length, high) - lowerBound(array, length, low);
+  }
+
+  // The searches in the same array all take the same number of branchless
+  // steps, so a group of them can advance in lockstep: each search
+  // prefetches the element its next step compares against and then waits
+  // while the rest of the group takes their steps, so up to BATCH_GROUP
+  // cache misses are in flight at once instead of one.
+  const int BATCH_GROUP = 16;
+
+  // Writes lowerBound() (or upperBound(), if Upper) of each of the count
+  // keys in group, at most BATCH_GROUP of them, to bounds
+  template <bool Upper, typename T>
+  void boundGroup(T array[], const int length, const T group[], const int count, int bounds[]) {
+    if (length <= 0) {
+      for (int g = 0; g < count; g++) bounds[g] = 0;
+      return;
+    }
+    int bases[BATCH_GROUP] = {};
+    for (int remaining = length; remaining > 1;) {
+      int half = remaining / 2;
+      remaining -= half;
+      for (int g = 0; g < count; g++) {
+        if constexpr (Upper) {
+          bases[g] += !(group[g] < array[bases[g] + half]) * half;
+        } else {
+          bases[g] += (array[bases[g] + half] < group[g]) * half;
+        }
+        CSI281_PREFETCH(array + bases[g] + remaining / 2);
+      }
+    }
+    for (int g = 0; g < count; g++) {
+      if constexpr (Upper) {
+        bounds[g] = bases[g] + !(group[g] < array[bases[g]]);
+      } else {
+        bounds[g] = bases[g] + (array[bases[g]] < group[g]);
+      }
+    }
+  }
+
+  // Search for numKeys keys at once, writing the first location of keys[i]
+  // (or -1) to out[i], like branchlessBinarySearch() would
+  template <typename T>
+  void binarySearchBatch(T array[], const int length, const T keys[], const int numKeys,
+                         int out[]) {
+    for (int first = 0; first < numKeys; first += BATCH_GROUP) {
+      const int count = numKeys - first < BATCH_GROUP ? numKeys - first : BATCH_GROUP;
+      boundGroup<false>(array, length, keys + first, count, out + first);
+      for (int g = first; g < first + count; g++) {
+        out[g] = out[g] < length && array[out[g]] == keys[g] ? out[g] : -1;
+      }
+    }
+  }
+
+  // Count numRanges ranges at once, writing countInRange() of lows[i] to
+  // highs[i] to out[i]
+  template <typename T>
+  void countInRangeBatch(T array[], const int length, const T lows[], const T highs[],
+                         const int numRanges, int out[]) {
+    for (int first = 0; first < numRanges; first += BATCH_GROUP) {
+      const int count = numRanges - first < BATCH_GROUP ? numRanges - first : BATCH_GROUP;
+      int starts[BATCH_GROUP];
+      boundGroup<false>(array, length, lows + first, count, starts);
+      boundGroup<true>(array, length, highs + first, count, out + first);
+      for (int g = 0; g < count; g++) {
+        int ends = out[first + g];
+        out[first + g] = highs[first + g] < lows[first + g] ? 0 : ends - starts[g];
+      }
+    }
+  }
 }  // namespace csi281
 
 #endif /* search_hpp */
@@ -0,0 +1,86 @@
+//
+//  searchAvx2.cpp
+//
+//  AVX2 versions of the linear search specializations. This file is
+//  built with AVX2 enabled (see CMakeLists.txt) and search.cpp only calls
+//  into it after checking that the processor supports AVX2.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+
+#  include "simdSearch.h"
+#endif
+
+namespace csi281 {
+#if defined(__AVX2__)
+  struct Avx2Int {
+    using Vec = __m256i;
+    static constexpr int LANES = 8;
+    static Vec broadcast(const int key) { return _mm256_set1_epi32(key); }
+    static unsigned matches(const int *values, const Vec key) {
+      Vec loaded = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+      return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(loaded, key)));
+    }
+  };
+
+  struct Avx2Float {
+    using Vec = __m256;
+    static constexpr int LANES = 8;
+    static Vec broadcast(const float key) { return _mm256_set1_ps(key); }
+    static unsigned matches(const float *values, const Vec key) {
+      return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values), key, _CMP_EQ_OQ));
+    }
+  };
+
+  struct Avx2Double {
+    using Vec = __m256d;
+    static constexpr int LANES = 4;
+    static Vec broadcast(const double key) { return _mm256_set1_pd(key); }
+    static unsigned matches(const double *values, const Vec key) {
+      return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values), key, _CMP_EQ_OQ));
+    }
+  };
+
+  bool avx2SearchCompiled() { return true; }
+
+  int linearSearchAvx2(const int array[], const int length, const int key) {
+    return firstMatch<Avx2Int>(array, length, key);
+  }
+
+  int linearSearchAvx2(const float array[], const int length, const float key) {
+    return firstMatch<Avx2Float>(array, length, key);
+  }
+
+  int linearSearchAvx2(const double array[], const int length, const double key) {
+    return firstMatch<Avx2Double>(array, length, key);
+  }
+#else
+  // Built without AVX2 (not an x86 compiler, or not through CMakeLists.txt),
+  // so search.cpp never calls these
+  bool avx2SearchCompiled() { return false; }
+  int linearSearchAvx2(const int[], const int, const int) { return -1; }
+  int linearSearchAvx2(const float[], const int, const float) { return -1; }
+  int linearSearchAvx2(const double[], const int, const double) { return -1; }
+#endif
+}  // namespace csi281
@@ -0,0 +1,81 @@
+//
+//  simdSearch.h
+//
+//  The vectorized linear search loop shared by search.cpp and
+//  searchAvx2.cpp. Only those two files include it.
+//
+//  Copyright 2019 David Kopec
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation files
+//  (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge,
+//  publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so,
+//  subject to the following conditions:
+//
+//  The above copyright notice and this permission notice
+//  shall be included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+//  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//  OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef simdSearch_hpp
+#define simdSearch_hpp
+
+#ifdef _MSC_VER
+#  include <intrin.h>  // for _BitScanForward()
+#endif
+
+// Everything here is in an unnamed namespace, so each file that includes it
+// gets its own copy built for its own instruction set. The header includes
+// no standard library headers for the same reason: inline functions compiled
+// for AVX2 must never be shared with code that runs on older processors.
+namespace csi281 {
+  namespace {
+    // Index of the lowest set bit of a nonzero mask
+    inline int lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return static_cast<int>(index);
+#else
+      return __builtin_ctz(mask);
+#endif
+    }
+
+    // Returns the first location of key in array or -1, comparing Ops::LANES
+    // elements per instruction. Ops::matches() gives a bitmask with a bit set
+    // for every lane equal to the key (movemask), so the first hit is the
+    // lowest set bit. Four vectors are checked per step to keep the loop
+    // overhead down.
+    template <typename Ops, typename T>
+    int firstMatch(const T array[], const int length, const T key) {
+      const int LANES = Ops::LANES;
+      typename Ops::Vec broadcastKey = Ops::broadcast(key);
+      int i = 0;
+      for (; i + 4 * LANES <= length; i += 4 * LANES) {
+        unsigned mask = Ops::matches(array + i, broadcastKey)
+                        | Ops::matches(array + i + LANES, broadcastKey) << LANES
+                        | Ops::matches(array + i + 2 * LANES, broadcastKey) << 2 * LANES
+                        | Ops::matches(array + i + 3 * LANES, broadcastKey) << 3 * LANES;
+        if (mask != 0) return i + lowestBit(mask);
+      }
+      for (; i + LANES <= length; i += LANES) {
+        unsigned mask = Ops::matches(array + i, broadcastKey);
+        if (mask != 0) return i + lowestBit(mask);
+      }
+      for (; i < length; i++) {
+        if (array[i] == key) return i;
+      }
+      return -1;
+    }
+  }  // namespace
+}  // namespace csi281
+
+#endif /* simdSearch_hpp */
@@ -32,6 +32,15 @@
 #define TEST_CASE(name, tags) DOCTEST_TEST_CASE(tags " " name)
 using doctest::Approx;
 
+#include <cmath>    // for NAN and INFINITY
+#include <random>   // for mt19937
+#include <sstream>  // for ostringstream
+
+#include "Benchmark.h"
+#include "EytzingerIndex.h"
+#include "FractionalCascade.h"
+#include "LearnedIndex.h"
+#include "STree.h"
 #include "search.h"
 #include "util.h"
 
@@ -144,6 +153,68 @@ TEST_CASE("Random Int Array", "[Random]") {
   }
 }
 
+TEST_CASE("Seeded Random Int Array", "[Random]") {
+  SECTION("The same seed gives the same array, sorted") {
+    const int N = 300000;  // big enough to be split among threads
+    int *first = randomIntArray(N, -1000000, 1000000, 281);
+    int *second = randomIntArray(N, -1000000, 1000000, 281);
+    int *other = randomIntArray(N, -1000000, 1000000, 282);
+    REQUIRE(equal(first, first + N, second));
+    REQUIRE_FALSE(equal(first, first + N, other));
+    REQUIRE(is_sorted(first, first + N));
+    REQUIRE(first[0] >= -1000000);
+    REQUIRE(first[0] < -990000);
+    REQUIRE(first[N - 1] <= 1000000);
+    REQUIRE(first[N - 1] > 990000);
+    delete[] first;
+    delete[] second;
+    delete[] other;
+  }
+
+  SECTION("The whole range of int") {
+    const int N = 1000;
+    int *randArray = randomIntArray(N, numeric_limits<int>::min(), numeric_limits<int>::max(), 7);
+    REQUIRE(is_sorted(randArray, randArray + N));
+    REQUIRE(randArray[0] < -1000000000);
+    REQUIRE(randArray[N - 1] > 1000000000);
+    delete[] randArray;
+  }
+}
+
+TEST_CASE("Parallel Radix Sort", "[Radix]") {
+  SECTION("Same order as sort()") {
+    mt19937 generator(281);
+    for (int length : {0, 1, 2, 17, 1000, 200000}) {
+      for (int bits : {1, 9, 20, 32}) {
+        vector<int> values(length);
+        for (int &value : values) {
+          value = static_cast<int>(generator() >> (32 - bits)) - (bits < 32 ? 1 << (bits - 1) : 0);
+        }
+        vector<int> expected = values;
+        sort(expected.begin(), expected.end());
+        parallelRadixSort(values.data(), length);
+        REQUIRE(values == expected);
+      }
+    }
+  }
+
+  SECTION("Already sorted, reversed and all the same") {
+    vector<int> up(100000), down(100000), same(100000, -5);
+    for (int i = 0; i < 100000; i++) {
+      up[i] = i * 3 - 150000;
+      down[i] = 150000 - i * 3;
+    }
+    vector<int> sortedUp = up;
+    parallelRadixSort(up.data(), 100000);
+    parallelRadixSort(down.data(), 100000);
+    parallelRadixSort(same.data(), 100000);
+    REQUIRE(up == sortedUp);
+    REQUIRE(is_sorted(down.begin(), down.end()));
+    REQUIRE(down.front() == 150000 - 99999 * 3);
+    REQUIRE(same == vector<int>(100000, -5));
+  }
+}
+
 TEST_CASE("Array Search Speed", "[Speed]") {
   const int N = 100000;
   const int NUM_TESTS = 1000;
@@ -153,3 +224,430 @@ TEST_CASE("Array Search Speed", "[Speed]") {
     REQUIRE(speeds.first.count() > speeds.second.count());
   }
 }
+
+TEST_CASE("Branchless Binary Search", "[Branchless]") {
+  SECTION("Same results as binarySearch") {
+    const int N = 5000;
+    int *array = new int[N];
+    for (int i = 0; i < N; i++) array[i] = 3 * i;  // distinct, with gaps between them
+    for (int length : {0, 1, 2, 3, 7, 64, 1000, N}) {
+      for (int key = -2; key <= 3 * length + 2; key++) {
+        int expected = binarySearch(array, length, key);
+        REQUIRE(branchlessBinarySearch(array, length, key) == expected);
+        REQUIRE(branchlessBinarySearch<true>(array, length, key) == expected);
+      }
+    }
+    delete[] array;
+  }
+
+  SECTION("Duplicates give the first of them") {
+    int sampleIntArray[8] = {4, 4, 7, 7, 7, 72, 84, 84};
+    REQUIRE(branchlessBinarySearch(sampleIntArray, 8, 7) == 2);
+    REQUIRE(branchlessBinarySearch(sampleIntArray, 8, 84) == 6);
+    REQUIRE(branchlessBinarySearch(sampleIntArray, 8, 5) == -1);
+  }
+
+  SECTION("float and char Tests") {
+    float sampleFloatArray[4] = {2.1f, 4.0f, 11.5f, 17.1f};
+    REQUIRE(branchlessBinarySearch<true>(sampleFloatArray, 4, 11.5f) == 2);
+    char sampleCharArray[4] = {'a', 'c', 'f', 'r'};
+    REQUIRE(branchlessBinarySearch(sampleCharArray, 4, 'a') == 0);
+  }
+}
+
+TEST_CASE("Eytzinger Index", "[Eytzinger]") {
+  SECTION("Every length up to a few levels") {
+    int sorted[100];
+    for (int i = 0; i < 100; i++) sorted[i] = 2 * i;
+    for (int length = 0; length <= 100; length++) {
+      EytzingerIndex<int> index(sorted, length);
+      REQUIRE(index.size() == length);
+      for (int key = -1; key <= 2 * length; key++) {
+        REQUIRE(index.search(key) == binarySearch(sorted, length, key));
+      }
+    }
+  }
+
+  SECTION("Duplicates give the first of them, like the branchless search") {
+    const int N = 20000;
+    int *randArray = randomIntArray(N, 0, 5000);
+    EytzingerIndex<int> index(randArray, N);
+    for (int key = -10; key <= 5010; key++) {
+      REQUIRE(index.search(key) == branchlessBinarySearch(randArray, N, key));
+    }
+    delete[] randArray;
+  }
+
+  SECTION("float Test") {
+    float sampleFloatArray[5] = {2.1f, 4.0f, 11.5f, 17.1f, 20.0f};
+    EytzingerIndex<float> index(sampleFloatArray, 5);
+    REQUIRE(index.search(17.1f) == 3);
+    REQUIRE(index.search(3.0f) == -1);
+  }
+}
+
+TEST_CASE("Vectorized Linear Search", "[SIMD]") {
+  // every length through a few vector widths, with the key at every position
+  SECTION("Same as a plain loop for int, float and double") {
+    const int N = 80;
+    int ints[N];
+    float floats[N];
+    double doubles[N];
+    for (int length = 0; length <= N; length++) {
+      for (int hit = -1; hit < length; hit++) {
+        for (int i = 0; i < length; i++) {
+          ints[i] = i == hit ? -7 : i;
+          floats[i] = i == hit ? -7.5f : i;
+          doubles[i] = i == hit ? -7.25 : i;
+        }
+        REQUIRE(linearSearch(ints, length, -7) == hit);
+        REQUIRE(linearSearch(floats, length, -7.5f) == hit);
+        REQUIRE(linearSearch(doubles, length, -7.25) == hit);
+      }
+    }
+  }
+
+  SECTION("First of several matches") {
+    int sampleIntArray[40] = {};
+    sampleIntArray[33] = 9;
+    sampleIntArray[37] = 9;
+    sampleIntArray[21] = 9;
+    REQUIRE(linearSearch(sampleIntArray, 40, 9) == 21);
+    REQUIRE(linearSearch(sampleIntArray, 40, 0) == 0);
+  }
+
+  SECTION("Floating point equality") {
+    double sampleDoubleArray[9] = {1, 2, 3, 4, 5, 6, 7, -0.0, NAN};
+    REQUIRE(linearSearch(sampleDoubleArray, 9, 0.0) == 7);  // -0.0 == 0.0
+    REQUIRE(linearSearch(sampleDoubleArray, 9, static_cast<double>(NAN)) == -1);
+  }
+}
+
+TEST_CASE("Batched Binary Search", "[Batch]") {
+  SECTION("Same as searching one key at a time") {
+    const int N = 30000;
+    const int NUM_KEYS = 1001;  // not a whole number of groups
+    int *randArray = randomIntArray(N, 0, 2 * N);
+    int *keys = randomIntArray(NUM_KEYS, -5, 2 * N + 5);
+    int found[NUM_KEYS];
+    for (int length : {0, 1, 2, 17, N}) {
+      binarySearchBatch(randArray, length, keys, NUM_KEYS, found);
+      for (int i = 0; i < NUM_KEYS; i++) {
+        REQUIRE(found[i] == branchlessBinarySearch(randArray, length, keys[i]));
+      }
+    }
+    delete[] randArray;
+    delete[] keys;
+  }
+
+  SECTION("float Test") {
+    float sampleFloatArray[4] = {2.1f, 4.0f, 11.5f, 17.1f};
+    float keys[3] = {17.1f, 3.0f, 2.1f};
+    int found[3];
+    binarySearchBatch(sampleFloatArray, 4, keys, 3, found);
+    REQUIRE(found[0] == 3);
+    REQUIRE(found[1] == -1);
+    REQUIRE(found[2] == 0);
+  }
+}
+
+TEST_CASE("Interpolation and Exponential Search", "[Interpolation]") {
+  const int N = 20000;
+  int *randArray = randomIntArray(N, 0, 3 * N);
+
+  SECTION("Find what binarySearch finds") {
+    for (int key = -3; key <= 3 * N + 3; key += 7) {
+      bool present = binarySearch(randArray, N, key) != -1;
+      int viaInterpolation = interpolationSearch(randArray, N, key);
+      int viaExponential = exponentialSearch(randArray, N, key);
+      int viaHint = exponentialSearch(randArray, N, key, key / 3);
+      REQUIRE((viaInterpolation != -1) == present);
+      REQUIRE((viaExponential != -1) == present);
+      REQUIRE((viaHint != -1) == present);
+      if (present) {
+        REQUIRE(randArray[viaInterpolation] == key);
+        REQUIRE(randArray[viaExponential] == key);
+        REQUIRE(randArray[viaHint] == key);
+      }
+    }
+  }
+
+  SECTION("Skewed data and hints at the edges") {
+    // mostly tiny values and then a few huge ones, the worst case for guessing
+    int skewed[1000];
+    for (int i = 0; i < 1000; i++) skewed[i] = i < 990 ? i : 1000000 * (i - 989);
+    for (int i = 0; i < 1000; i++) {
+      REQUIRE(interpolationSearch(skewed, 1000, skewed[i]) == i);
+      REQUIRE(exponentialSearch(skewed, 1000, skewed[i], 999) == i);
+      REQUIRE(exponentialSearch(skewed, 1000, skewed[i], -4) == i);
+    }
+    REQUIRE(interpolationSearch(skewed, 1000, 995) == -1);
+    REQUIRE(exponentialSearch(skewed, 0, 5) == -1);
+    REQUIRE(interpolationSearch(skewed, 0, 5) == -1);
+  }
+
+  SECTION("float Test") {
+    float sampleFloatArray[5] = {2.1f, 4.0f, 11.5f, 17.1f, 20.0f};
+    REQUIRE(interpolationSearch(sampleFloatArray, 5, 17.1f) == 3);
+    REQUIRE(exponentialSearch(sampleFloatArray, 5, 2.1f, 4) == 0);
+    REQUIRE(exponentialSearch(sampleFloatArray, 5, 11.6f, 2) == -1);
+  }
+
+  SECTION("Infinite ends and NaN keys") {
+    double withInfinities[5] = {-INFINITY, -1.5, 0, 2.5, INFINITY};
+    for (int i = 0; i < 5; i++) {
+      REQUIRE(interpolationSearch(withInfinities, 5, withInfinities[i]) == i);
+    }
+    REQUIRE(interpolationSearch(withInfinities, 5, 1.0) == -1);
+    REQUIRE(interpolationSearch(withInfinities, 5, static_cast<double>(NAN)) == -1);
+  }
+
+  delete[] randArray;
+}
+
+TEST_CASE("Learned Index", "[Learned]") {
+  SECTION("Same results as the branchless search, for several error bounds") {
+    const int N = 50000;
+    int *randArray = randomIntArray(N, 0, N / 2);  // plenty of duplicates
+    for (int maxError : {0, 1, 8, 64}) {
+      LearnedIndex<int> index(randArray, N, maxError);
+      REQUIRE(index.lineCount() >= 1);
+      for (int key = -3; key <= N / 2 + 3; key++) {
+        REQUIRE(index.search(key) == branchlessBinarySearch(randArray, N, key));
+      }
+    }
+    delete[] randArray;
+  }
+
+  SECTION("Evenly spread keys fit in one line") {
+    int line[1000];
+    for (int i = 0; i < 1000; i++) line[i] = 5 * i + 3;
+    LearnedIndex<int> index(line, 1000, 4);
+    REQUIRE(index.lineCount() == 1);
+    REQUIRE(index.search(5 * 700 + 3) == 700);
+    REQUIRE(index.search(5 * 700 + 4) == -1);
+  }
+
+  SECTION("Skewed keys and tiny arrays") {
+    double skewed[64];
+    for (int i = 0; i < 64; i++) skewed[i] = i < 60 ? i * 0.5 : 1e9 * (i - 59);
+    LearnedIndex<double> index(skewed, 64, 2);
+    for (int i = 0; i < 64; i++) REQUIRE(index.search(skewed[i]) == i);
+    REQUIRE(index.search(1e12) == -1);
+    REQUIRE(LearnedIndex<double>(skewed, 0).search(1.0) == -1);
+    REQUIRE(LearnedIndex<double>(skewed, 1).search(0.0) == 0);
+  }
+}
+
+TEST_CASE("Static B-Tree", "[STree]") {
+  SECTION("Every length through three levels") {
+    int sorted[400];
+    for (int i = 0; i < 400; i++) sorted[i] = 2 * i;
+    for (int length = 0; length <= 400; length++) {
+      STree<int> tree(sorted, length);
+      REQUIRE(tree.size() == length);
+      for (int key = -1; key <= 2 * length; key++) {
+        REQUIRE(tree.search(key) == binarySearch(sorted, length, key));
+      }
+    }
+  }
+
+  SECTION("Duplicates give the first of them, like the branchless search") {
+    const int N = 20000;
+    int *randArray = randomIntArray(N, 0, 5000);
+    STree<int> tree(randArray, N);
+    for (int key = -10; key <= 5010; key++) {
+      REQUIRE(tree.search(key) == branchlessBinarySearch(randArray, N, key));
+    }
+    delete[] randArray;
+  }
+
+  SECTION("The largest value isn't mistaken for padding") {
+    int extremes[5] = {numeric_limits<int>::min(), -1, 0, 1, numeric_limits<int>::max()};
+    REQUIRE(STree<int>(extremes, 5).search(numeric_limits<int>::max()) == 4);
+    REQUIRE(STree<int>(extremes, 4).search(numeric_limits<int>::max()) == -1);
+    REQUIRE(STree<int>(extremes, 5).search(numeric_limits<int>::min()) == 0);
+  }
+
+  SECTION("float, double and char") {
+    float floats[20];
+    double doubles[20];
+    char chars[20];
+    for (int i = 0; i < 20; i++) {
+      floats[i] = i * 1.5f;
+      doubles[i] = i * -0.25 + 100;
+      chars[i] = static_cast<char>('a' + i);
+    }
+    sort(doubles, doubles + 20);
+    STree<float> floatTree(floats, 20);
+    STree<double> doubleTree(doubles, 20);
+    STree<char> charTree(chars, 20);
+    for (int i = 0; i < 20; i++) {
+      REQUIRE(floatTree.search(floats[i]) == i);
+      REQUIRE(doubleTree.search(doubles[i]) == i);
+      REQUIRE(charTree.search(chars[i]) == i);
+    }
+    REQUIRE(floatTree.search(0.75f) == -1);
+    REQUIRE(floatTree.search(numeric_limits<float>::infinity()) == -1);
+    REQUIRE(charTree.search('z') == -1);
+  }
+}
+
+TEST_CASE("Benchmark Harness", "[Benchmark]") {
+  SECTION("Nearest rank percentiles") {
+    vector<nanoseconds> times;
+    for (int i = 100; i >= 1; i--) times.push_back(nanoseconds(i));
+    REQUIRE(percentile(times, 50) == nanoseconds(50));
+    REQUIRE(percentile(times, 99) == nanoseconds(99));
+    REQUIRE(percentile(times, 100) == nanoseconds(100));
+    REQUIRE(percentile({nanoseconds(7)}, 90) == nanoseconds(7));
+    REQUIRE(percentile({}, 50) == nanoseconds(0));
+  }
+
+  SECTION("Every repetition of every timer, warm and cold") {
+    for (CacheMode cache : {CacheMode::Warm, CacheMode::Cold}) {
+      BenchmarkOptions options;
+      options.warmups = 1;
+      options.repetitions = 7;
+      options.cache = cache;
+      options.evictBytes = 1 << 20;
+      int calls[2] = {0, 0};
+      int keysSearched[2] = {0, 0};
+      vector<SearchTimer> timers;
+      for (int t = 0; t < 2; t++) {
+        timers.push_back([&calls, &keysSearched, t](int[], const int length, const int[],
+                                                    const int numKeys) {
+          calls[t]++;
+          keysSearched[t] += numKeys;
+          REQUIRE(length == 500);
+          return nanoseconds(t + 1);
+        });
+      }
+      vector<SearchStats> stats = searchStats(timers, 500, 50, options);
+      REQUIRE(stats.size() == 2);
+      // cold searches are timed one key at a time after the warmup
+      int expectedCalls = cache == CacheMode::Warm ? 8 : 1 + 7 * 50;
+      REQUIRE(calls[0] == expectedCalls);
+      REQUIRE(calls[1] == expectedCalls);
+      REQUIRE(keysSearched[0] == 8 * 50);
+      REQUIRE(keysSearched[1] == 8 * 50);
+      REQUIRE(stats[1].p50 == nanoseconds(2));
+      REQUIRE(stats[1].p99 == nanoseconds(2));
+      REQUIRE(stats[1].mean == nanoseconds(2));
+    }
+  }
+
+  SECTION("CSV lines") {
+    ostringstream csv;
+    writeSearchCsvHeader(csv);
+    SearchStats stats = {nanoseconds(10), nanoseconds(12), nanoseconds(30), nanoseconds(11)};
+    writeSearchCsv(csv, "Binary Search, Sorted", CacheMode::Cold, 1000, stats);
+    REQUIRE(csv.str()
+            == "search,cache,n,p50,p90,p99,mean\n"
+               "\"Binary Search, Sorted\",cold,1000,10,12,30,11\n");
+  }
+}
+
+TEST_CASE("Fractional Cascading", "[Cascade]") {
+  SECTION("Same as a search in each array") {
+    const int COUNT = 12;
+    int *arrays[COUNT];
+    int lengths[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+      // empty, tiny and big arrays, with duplicates, over shifting ranges
+      lengths[i] = i % 4 == 0 ? i / 4 : 500 * i;
+      arrays[i] = randomIntArray(lengths[i], i * 50, 1000 + i * 100, i);
+    }
+    FractionalCascade<int> cascade(arrays, lengths, COUNT);
+    REQUIRE(cascade.size() == COUNT);
+    int found[COUNT];
+    for (int key = -5; key <= 2300; key++) {
+      cascade.search(key, found);
+      for (int i = 0; i < COUNT; i++) {
+        REQUIRE(found[i] == branchlessBinarySearch(arrays[i], lengths[i], key));
+      }
+    }
+    for (int i = 0; i < COUNT; i++) delete[] arrays[i];
+  }
+
+  SECTION("One array, no arrays and doubles") {
+    double evens[50], odds[50];
+    for (int i = 0; i < 50; i++) {
+      evens[i] = 2 * i;
+      odds[i] = 2 * i + 1;
+    }
+    const double *arrays[3] = {evens, odds, evens};
+    int lengths[3] = {50, 50, 10};
+    int found[3];
+    FractionalCascade<double> cascade(arrays, lengths, 3);
+    cascade.search(8, found);
+    REQUIRE(found[0] == 4);
+    REQUIRE(found[1] == -1);
+    REQUIRE(found[2] == 4);
+    cascade.search(99, found);
+    REQUIRE(found[0] == -1);
+    REQUIRE(found[1] == 49);
+    REQUIRE(found[2] == -1);
+
+    FractionalCascade<double> single(arrays, lengths, 1);
+    single.search(98, found);
+    REQUIRE(found[0] == 49);
+    FractionalCascade<double> none(arrays, lengths, 0);
+    REQUIRE(none.size() == 0);
+    none.search(1, found);
+  }
+}
+
+TEST_CASE("Bounds and Range Counts", "[Bounds]") {
+  SECTION("Same as the standard library, with heavy duplicates") {
+    for (int length : {0, 1, 2, 3, 16, 17, 1000}) {
+      int *randArray = randomIntArray(length, 0, 20, length);
+      for (int key = -2; key <= 22; key++) {
+        int *first = lower_bound(randArray, randArray + length, key);
+        int *last = upper_bound(randArray, randArray + length, key);
+        REQUIRE(lowerBound(randArray, length, key) == first - randArray);
+        REQUIRE(upperBound(randArray, length, key) == last - randArray);
+        auto range = equalRange(randArray, length, key);
+        REQUIRE(range.first == first - randArray);
+        REQUIRE(range.second == last - randArray);
+      }
+      delete[] randArray;
+    }
+  }
+
+  SECTION("Counting from low to high, both included") {
+    const int N = 5000;
+    int *randArray = randomIntArray(N, -100, 100, 281);
+    vector<int> lows, highs, expected;
+    for (int low = -105; low <= 105; low += 7) {
+      for (int high = low - 3; high <= 105; high += 11) {
+        lows.push_back(low);
+        highs.push_back(high);
+        expected.push_back(static_cast<int>(
+            count_if(randArray, randArray + N, [=](int x) { return low <= x && x <= high; })));
+      }
+    }
+    const int numRanges = static_cast<int>(lows.size());
+    vector<int> counted(numRanges);
+    countInRangeBatch(randArray, N, lows.data(), highs.data(), numRanges, counted.data());
+    for (int i = 0; i < numRanges; i++) {
+      REQUIRE(countInRange(randArray, N, lows[i], highs[i]) == expected[i]);
+      REQUIRE(counted[i] == expected[i]);
+    }
+    REQUIRE(countInRange(randArray, N, -100, 100) == N);
+    REQUIRE(countInRange(randArray, 0, -100, 100) == 0);
+    delete[] randArray;
+  }
+
+  SECTION("Floats") {
+    float sampleFloatArray[6] = {1.5f, 2.5f, 2.5f, 2.5f, 7.0f, 9.25f};
+    auto twoAndAHalf = equalRange(sampleFloatArray, 6, 2.5f);
+    REQUIRE(twoAndAHalf.first == 1);
+    REQUIRE(twoAndAHalf.second == 4);
+    auto three = equalRange(sampleFloatArray, 6, 3.0f);
+    REQUIRE(three.first == 4);
+    REQUIRE(three.second == 4);
+    REQUIRE(countInRange(sampleFloatArray, 6, 2.0f, 7.0f) == 4);
+    REQUIRE(countInRange(sampleFloatArray, 6, 7.0f, 2.0f) == 0);
+  }
+}
@@ -28,9 +28,13 @@
 #include "util.h"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <numeric>  // for accumulate()
 #include <random>
+#include <thread>
 
+#include "Benchmark.h"
 #include "search.h"
 
 using namespace std;
@@ -40,24 +44,107 @@ namespace csi281 {
   // Returns a new int array of *length* and filled
   // with numbers between *min* and *max*
   // Suggest using the facilities in STL <random>
-    // used setup from the uniform_int_distribution cpprefrence.com page
   int *randomIntArray(const int length, const int min, const int max) {
-    // YOUR CODE HERE
-    // used example from https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution.html
-    random_device rd;   // a seed source for the random number engine
-    mt19937 gen(rd());  // mersenne_twister_engine seeded with rd()
-    uniform_int_distribution<> distrib(min, max);
-    int *arrayToMake = new int[length];
+    random_device rd;  // a seed source for the random number generator
+    return randomIntArray(length, min, max, (static_cast<uint64_t>(rd()) << 32) | rd());
+  }
 
-    for (int i = 0; i < length; i++) {
-      *(arrayToMake + i) = distrib(gen);
+  // Below this many elements, starting threads costs more than it saves
+  static const int PARALLEL_MIN_LENGTH = 1 << 16;
+
+  static int threadsFor(const int length) {
+    if (length < PARALLEL_MIN_LENGTH) return 1;
+    return static_cast<int>(clamp(thread::hardware_concurrency(), 1u, 64u));
+  }
+
+  // Runs work(part, begin, end) over numParts contiguous ranges that cover
+  // [0, length), the last one on this thread
+  static void forEachPart(const int length, const int numParts,
+                          const function<void(int part, int begin, int end)> &work) {
+    vector<thread> helpers;
+    for (int part = 0; part < numParts; part++) {
+      int begin = static_cast<int>(static_cast<long long>(length) * part / numParts);
+      int end = static_cast<int>(static_cast<long long>(length) * (part + 1) / numParts);
+      if (part + 1 < numParts) {
+        helpers.emplace_back(work, part, begin, end);
+      } else {
+        work(part, begin, end);
+      }
     }
+    for (thread &helper : helpers) helper.join();
+  }
 
-    sort(arrayToMake, (arrayToMake + length));
+  // A counter based generator: the output function of SplitMix64 applied to
+  // the seed plus counter steps, so element i's number depends on nothing
+  // but the seed and i, and any split of the array among threads (each
+  // counting through its own part) makes the same array.
+  // See https://prng.di.unimi.it/splitmix64.c
+  static uint64_t counterRandom(const uint64_t seed, const uint64_t counter) {
+    uint64_t z = seed + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
 
+  int *randomIntArray(const int length, const int min, const int max, const uint64_t seed) {
+    int *arrayToMake = new int[length];
+    // scale the top 32 bits into the range with a multiply instead of a
+    // division (Lemire); the bias is at most range / 2^32
+    const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+    forEachPart(length, threadsFor(length), [&](int, int begin, int end) {
+      for (int i = begin; i < end; i++) {
+        uint64_t offset = ((counterRandom(seed, i) >> 32) * range) >> 32;
+        arrayToMake[i] = static_cast<int>(min + static_cast<int64_t>(offset));
+      }
+    });
+    parallelRadixSort(arrayToMake, length);
     return arrayToMake;
   }
 
+  // Each pass sorts on one byte, stably, so after the pass on the most
+  // significant byte the array is in order. Each thread counts the digits
+  // in its own part, the counts give every (digit, part) pair its own run of
+  // the output, and then each thread moves its part into its runs. Bytes
+  // that are the same in every element are skipped, so small ranges of
+  // values take fewer passes.
+  void parallelRadixSort(int array[], const int length) {
+    if (length < 2) return;
+    const int RADIX = 256;
+    // flipping the sign bit orders negative numbers before positive ones
+    auto key = [](const int value) { return static_cast<uint32_t>(value) ^ 0x80000000u; };
+    uint32_t differing = 0;
+    for (int i = 1; i < length; i++) differing |= key(array[i]) ^ key(array[0]);
+
+    const int numParts = threadsFor(length);
+    int *buffer = new int[length];
+    int *from = array, *to = buffer;
+    vector<std::array<int, RADIX>> counts(numParts);
+    for (int shift = 0; shift < 32; shift += 8) {
+      if (((differing >> shift) & (RADIX - 1)) == 0) continue;
+      forEachPart(length, numParts, [&](int part, int begin, int end) {
+        counts[part].fill(0);
+        for (int i = begin; i < end; i++) counts[part][(key(from[i]) >> shift) & (RADIX - 1)]++;
+      });
+      int start = 0;
+      for (int digit = 0; digit < RADIX; digit++) {
+        for (int part = 0; part < numParts; part++) {
+          int count = counts[part][digit];
+          counts[part][digit] = start;
+          start += count;
+        }
+      }
+      forEachPart(length, numParts, [&](int part, int begin, int end) {
+        std::array<int, RADIX> &next = counts[part];
+        for (int i = begin; i < end; i++) {
+          to[next[(key(from[i]) >> shift) & (RADIX - 1)]++] = from[i];
+        }
+      });
+      swap(from, to);
+    }
+    if (from != array) copy(from, from + length, array);
+    delete[] buffer;
+  }
+
   // Finds the speed of linear versus binary search
   // in a random int array of *length* size
   // by running *numTests* and averaging them
@@ -65,56 +152,23 @@ namespace csi281 {
   // to do linear search and binary search in nanoseconds
   // Linear search should be first in the pair, and binary search
   // should be second
-  //
-  // Suggest using the facilities in STL <chrono>
-  // For example, you can start a timer using
-  // using namespace std::chrono;
-  // auto start = duration_cast< nanoseconds >(system_clock::now().time_since_epoch()).count();
-  // and stop a timer using
-  // auto end = duration_cast< nanoseconds >(system_clock::now().time_since_epoch()).count();
-  // start, end will be results in nanoseconds
   pair<nanoseconds, nanoseconds> arraySearchSpeed(const int length, const int numTests) {
-    int *testArray = randomIntArray(length, 0, length);
-    int *testKeys = randomIntArray(numTests, 0, length);
-
-    using namespace std::chrono;
-
-    // Do numTests linear searches and find the average time
-    // Put the result in a variable linearSearchSpeed
-
-    // YOUR CODE HERE
-    // got this more precise idea from this article: https://www.geeksforgeeks.org/c/measure-execution-time-with-high-precision-in-c-c/
-    auto start = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-
-    for (int i = 0; i < numTests; i++) {
-      linearSearch
-      (testArray, 
-          length, 
-          *(testKeys + i));
-    }
-
-    auto end = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-    //double time_taken = duration_cast<nanoseconds>(end - start).count();
-    nanoseconds linearSearchSpeed = (nanoseconds)((end - start) / numTests);
-
-    // Do numTests binary searches and find the average time
-    // Put the result in a variable binarySearchSpeed
-
-    // YOUR CODE HERE
-
-    auto start2 = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-
-    for (int i = 0; i < numTests; i++) {
-      binarySearch(testArray, length, *(testKeys + i));
-    }
-
-    auto end2 = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-    // double time_taken = duration_cast<nanoseconds>(end - start).count();
-    nanoseconds binarySearchSpeed = (nanoseconds)((end2 - start2) / numTests);
-
-    delete testArray;
-    delete testKeys;
+    BenchmarkOptions options;
+    options.repetitions = 5;  // linear search over a big array takes a while
+    vector<SearchStats> stats
+        = searchStats({eachKey(linearSearch<int>), eachKey(binarySearch<int>)}, length, numTests,
+                      options);
+    return pair<nanoseconds, nanoseconds>(stats[0].p50, stats[1].p50);
+  }
 
-    return pair<nanoseconds, nanoseconds>(linearSearchSpeed, binarySearchSpeed);
+  SearchTimer batchedKeys() {
+    return [](int array[], const int length, const int keys[], const int numKeys) {
+      vector<int> found(numKeys);
+      auto start = BenchmarkClock::now();
+      binarySearchBatch(array, length, keys, numKeys, found.data());
+      auto end = BenchmarkClock::now();
+      doNotOptimize(accumulate(found.begin(), found.end(), 0LL));
+      return duration_cast<nanoseconds>(end - start) / numKeys;
+    };
   }
 }  // namespace csi281
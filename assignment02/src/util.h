@@ -28,8 +28,12 @@
 #ifndef util_hpp
 #define util_hpp
 
-#include <chrono>   // for nanoseconds
+#include <chrono>  // for nanoseconds
+#include <cstdint>
+#include <functional>
+#include <type_traits>  // for conditional_t
 #include <utility>  // for pair
+#include <vector>
 
 #include "MemoryLeakDetector.h"
 
@@ -37,8 +41,62 @@ using namespace std;
 using namespace std::chrono;
 
 namespace csi281 {
+  // Any of the searches in search.h over an int array
+  using IntSearch = int (*)(int[], const int, const int);
+
+  // Times one way of searching for every key in keys, giving back the
+  // average time per key
+  using SearchTimer
+      = function<nanoseconds(int array[], const int length, const int keys[], const int numKeys)>;
+
   int *randomIntArray(const int length, const int min, const int max);
+  // The same sorted array every time for the same seed, however many
+  // threads fill and sort it
+  int *randomIntArray(const int length, const int min, const int max, const uint64_t seed);
+  // Sorts array from least to greatest one byte at a time, splitting each
+  // pass across all of the cores
+  void parallelRadixSort(int array[], const int length);
   pair<nanoseconds, nanoseconds> arraySearchSpeed(const int length, const int numTests);
+
+  // The clock benchmarks read: the finest one that never goes backwards
+  using BenchmarkClock
+      = conditional_t<high_resolution_clock::is_steady, high_resolution_clock, steady_clock>;
+
+  // Makes the compiler treat value as read, so the work that computes it
+  // can't be optimized away, without the cost of storing it anywhere.
+  // Elsewhere the value goes through a volatile store, so T must be a scalar.
+  template <typename T> inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+  }
+
+  // Average time of search(array, length, key) over every key in keys.
+  // The results are added up and handed to doNotOptimize() so the searches
+  // can't be optimized away.
+  template <typename Search>
+  nanoseconds averageSearchTime(int array[], const int length, const int keys[],
+                                const int numKeys, Search search) {
+    long long found = 0;
+    auto start = BenchmarkClock::now();
+    for (int i = 0; i < numKeys; i++) found += search(array, length, keys[i]);
+    auto end = BenchmarkClock::now();
+    doNotOptimize(found);
+    return duration_cast<nanoseconds>(end - start) / numKeys;
+  }
+
+  // Time a search one key after another
+  template <typename Search> SearchTimer eachKey(Search search) {
+    return [search](int array[], const int length, const int keys[], const int numKeys) {
+      return averageSearchTime(array, length, keys, numKeys, search);
+    };
+  }
+
+  // Time binarySearchBatch() over all of the keys at once
+  SearchTimer batchedKeys();
 }  // namespace csi281
 
 #endif /* util_hpp */